@@ -1,50 +1,139 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <variant>
+#include <vector>
+
+std::atomic<std::uint64_t> g_heap_allocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
 
 struct PayReq {
     std::string orderId;
     int amount;
 };
 
+// Small-buffer string: messages up to kInlineCapacity bytes stay inline, longer ones (an unusually
+// long order id) move to the heap instead of failing a payment that has already gone through.
+class PayMessage {
+public:
+    static constexpr std::size_t kInlineCapacity = 95;
+
+    PayMessage() = default;
+    explicit PayMessage(std::string_view text) { append(text); }
+
+    PayMessage& append(std::string_view text) {
+        if (!heap_.empty()) {
+            heap_.append(text);
+        } else if (text.size() > kInlineCapacity - size_) {
+            heap_.reserve(size_ + text.size());
+            heap_.assign(buf_, size_);
+            heap_.append(text);
+        } else {
+            std::memcpy(buf_ + size_, text.data(), text.size());
+            size_ += text.size();
+        }
+        return *this;
+    }
+
+    PayMessage& append(int value) {
+        char digits[12];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return append(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+    }
+
+    std::string_view view() const { return heap_.empty() ? std::string_view(buf_, size_) : heap_; }
+
+    bool inlined() const { return heap_.empty(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const PayMessage& msg) { return os << msg.view(); }
+
+private:
+    char buf_[kInlineCapacity];
+    std::size_t size_ = 0;  // inline bytes; unused once heap_ holds the message
+    std::string heap_;
+};
+
 struct PayResp {
     bool ok;
-    std::string msg;
+    PayMessage msg;
 };
 
+PayMessage paidMessage(std::string_view channel, const PayReq& req) {
+    PayMessage msg;
+    msg.append(channel).append(" paid order=").append(req.orderId).append(", amount=").append(req.amount);
+    return msg;
+}
+
 class PaymentClient {
 public:
     virtual ~PaymentClient() = default;
     virtual PayResp pay(const PayReq& req) = 0;
+
+    // Settles reqs in order into out, advancing settled past each one. If it throws, out[0, settled)
+    // are real outcomes and the rest were not charged by this call.
+    virtual void payBatch(const PayReq* const* reqs, std::size_t count, PayResp* out, std::size_t& settled) {
+        for (settled = 0; settled < count; ++settled) {
+            out[settled] = pay(*reqs[settled]);
+        }
+    }
 };
 
 class PaymentClientFactory {
 public:
     virtual ~PaymentClientFactory() = default;
     virtual std::unique_ptr<PaymentClient> create() = 0;
+    virtual void reset(PaymentClient& client) { (void)client; }
 };
 
 class AlipayClient final : public PaymentClient {
 public:
     PayResp pay(const PayReq& req) override {
-        return {true, "alipay paid order=" + req.orderId + ", amount=" + std::to_string(req.amount)};
+        return {true, paidMessage("alipay", req)};
     }
 };
 
 class WechatPayClient final : public PaymentClient {
 public:
     PayResp pay(const PayReq& req) override {
-        return {true, "wechat paid order=" + req.orderId + ", amount=" + std::to_string(req.amount)};
+        return {true, paidMessage("wechat", req)};
     }
 };
 
 class BankCardPayClient final : public PaymentClient {
 public:
     PayResp pay(const PayReq& req) override {
-        return {true, "bank_card paid order=" + req.orderId + ", amount=" + std::to_string(req.amount)};
+        return {true, paidMessage("bank_card", req)};
     }
 };
 
@@ -69,28 +158,609 @@ public:
     }
 };
 
+struct PoolStats {
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t waits;
+};
+
+class PaymentClientPool {
+public:
+    class Lease {
+    public:
+        Lease(PaymentClientPool& pool, std::uint32_t slot) : pool_(&pool), slot_(slot) {}
+        Lease(Lease&& other) noexcept : pool_(std::exchange(other.pool_, nullptr)), slot_(other.slot_) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            if (pool_ != nullptr) {
+                pool_->release(slot_);
+            }
+        }
+
+        PaymentClient* operator->() const { return pool_->slots_[slot_].client.get(); }
+        PaymentClient& operator*() const { return *pool_->slots_[slot_].client; }
+
+    private:
+        PaymentClientPool* pool_;
+        std::uint32_t slot_;
+    };
+
+    PaymentClientPool(PaymentClientFactory& factory, std::size_t capacity)
+        : factory_(factory), capacity_(static_cast<std::uint32_t>(capacity)), slots_(new Slot[capacity]) {
+        if (capacity == 0 || capacity >= kNil) {
+            throw std::invalid_argument("PaymentClientPool: invalid capacity");
+        }
+        for (std::uint32_t slot = capacity_; slot-- > 0;) {
+            push(slot);
+        }
+    }
+
+    Lease checkout() {
+        std::uint32_t slot = kNil;
+        if (!tryPop(slot)) {
+            waits_.fetch_add(1, std::memory_order_relaxed);
+            while (!tryPop(slot)) {
+                std::this_thread::yield();
+            }
+        }
+        Slot& entry = slots_[slot];
+        if (entry.client == nullptr) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            try {
+                entry.client = factory_.create();
+            } catch (...) {
+                push(slot);
+                throw;
+            }
+        } else {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return Lease(*this, slot);
+    }
+
+    PoolStats stats() const {
+        return PoolStats{hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed),
+                         waits_.load(std::memory_order_relaxed)};
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr std::uint32_t kNil = 0xffffffffu;
+
+    struct Slot {
+        std::unique_ptr<PaymentClient> client;
+        std::atomic<std::uint32_t> next{kNil};
+    };
+
+    void release(std::uint32_t slot) {
+        factory_.reset(*slots_[slot].client);
+        push(slot);
+    }
+
+    void push(std::uint32_t slot) {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        std::uint64_t desired = 0;
+        do {
+            slots_[slot].next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            desired = (((head >> 32) + 1) << 32) | slot;
+        } while (!head_.compare_exchange_weak(head, desired, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    bool tryPop(std::uint32_t& slot) {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            const auto top = static_cast<std::uint32_t>(head);
+            if (top == kNil) {
+                return false;
+            }
+            const std::uint64_t next = slots_[top].next.load(std::memory_order_relaxed);
+            const std::uint64_t desired = (((head >> 32) + 1) << 32) | next;
+            if (head_.compare_exchange_weak(head, desired, std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                slot = top;
+                return true;
+            }
+        }
+    }
+
+    PaymentClientFactory& factory_;
+    std::uint32_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::uint64_t> head_{kNil};
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> waits_{0};
+};
+
+struct ChannelHandle {
+    std::uint32_t index;
+};
+
+struct ChannelPayReq {
+    std::string channel;
+    PayReq req;
+};
+
+enum class PayStatus { Ok, Declined, UnsupportedChannel, Failed };
+
+struct BatchPayResult {
+    PayStatus status;
+    PayResp resp;
+};
+
+struct PayBatchOptions {
+    std::size_t batch_size = 256;
+    std::size_t workers = 4;
+    std::size_t max_workers_per_channel = 0;  // 0: all but one worker
+};
+
+// Helper threads for payBatch, kept for the life of the service. Threads start on first use and
+// grow to the largest helper count any call has asked for.
+class BatchWorkers {
+public:
+    BatchWorkers() = default;
+    BatchWorkers(const BatchWorkers&) = delete;
+    BatchWorkers& operator=(const BatchWorkers&) = delete;
+
+    ~BatchWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    // Queues fn for `helpers` threads; the futures carry its completion or exception.
+    std::vector<std::future<void>> spawn(std::size_t helpers, const std::function<void()>& fn) {
+        std::vector<std::future<void>> done;
+        if (helpers == 0) {
+            return done;
+        }
+        done.reserve(helpers);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (threads_.size() < helpers) {
+                threads_.emplace_back([this] { run(); });
+            }
+            for (std::size_t i = 0; i < helpers; ++i) {
+                std::packaged_task<void()> task(fn);
+                done.push_back(task.get_future());
+                tasks_.push_back(std::move(task));
+            }
+        }
+        ready_.notify_all();
+        return done;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::packaged_task<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
+
 class PaymentService {
 public:
-    void registerFactory(const std::string& channel, std::unique_ptr<PaymentClientFactory> factory) {
-        factories_[channel] = std::move(factory);
+    void registerFactory(const std::string& channel, std::unique_ptr<PaymentClientFactory> factory,
+                         std::size_t pool_size = 0) {
+        Channel entry;
+        entry.factory = std::move(factory);
+        if (pool_size > 0) {
+            entry.pool = std::make_unique<PaymentClientPool>(*entry.factory, pool_size);
+        }
+        const auto it = handles_.find(channel);
+        if (it != handles_.end()) {
+            channels_[it->second] = std::move(entry);
+            return;
+        }
+        handles_.emplace(channel, static_cast<std::uint32_t>(channels_.size()));
+        channels_.push_back(std::move(entry));
     }
 
-    PayResp pay(const std::string& channel, const PayReq& req) {
-        const auto it = factories_.find(channel);
-        if (it == factories_.end()) {
+    ChannelHandle resolve(const std::string& channel) const {
+        const auto it = handles_.find(channel);
+        if (it == handles_.end()) {
             throw std::invalid_argument("Unsupported channel: " + channel);
         }
-        return it->second->create()->pay(req);
+        return ChannelHandle{it->second};
+    }
+
+    PayResp pay(const std::string& channel, const PayReq& req) { return pay(resolve(channel), req); }
+
+    PayResp pay(ChannelHandle handle, const PayReq& req) {
+        return withClient(channels_.at(handle.index),
+                          [&req](PaymentClient& client) { return client.pay(req); });
+    }
+
+    std::vector<BatchPayResult> payBatch(const std::vector<ChannelPayReq>& reqs,
+                                         const PayBatchOptions& options = {}) {
+        return payBatch(reqs.data(), reqs.size(), options);
+    }
+
+    // Span-style entry point (pointer + count; the tree is C++17). Results come back in input order.
+    // Orders are grouped by channel and settled in chunks of batch_size by up to options.workers
+    // threads (the caller plus pooled helpers); at most max_workers_per_channel of them work on one
+    // channel at a time, so a slow channel leaves the rest free for the others.
+    std::vector<BatchPayResult> payBatch(const ChannelPayReq* reqs, std::size_t count,
+                                         const PayBatchOptions& options = {}) {
+        std::vector<BatchPayResult> results(count);
+        std::vector<std::vector<std::size_t>> by_channel(channels_.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto it = handles_.find(reqs[i].channel);
+            if (it == handles_.end()) {
+                results[i] = {PayStatus::UnsupportedChannel,
+                              {false, PayMessage("Unsupported channel: " + reqs[i].channel)}};
+                continue;
+            }
+            by_channel[it->second].push_back(i);
+        }
+
+        struct Lane {
+            std::uint32_t channel;
+            const std::vector<std::size_t>* indices;
+            std::size_t next = 0;
+            std::size_t in_flight = 0;
+        };
+        const std::size_t batch_size = std::max<std::size_t>(1, options.batch_size);
+        std::vector<Lane> lanes;
+        std::size_t chunks = 0;
+        for (std::uint32_t channel = 0; channel < by_channel.size(); ++channel) {
+            if (!by_channel[channel].empty()) {
+                lanes.push_back(Lane{channel, &by_channel[channel]});
+                chunks += (by_channel[channel].size() + batch_size - 1) / batch_size;
+            }
+        }
+        const std::size_t workers = std::min(std::max<std::size_t>(1, options.workers), std::max<std::size_t>(1, chunks));
+        const std::size_t per_channel =
+            options.max_workers_per_channel > 0 ? options.max_workers_per_channel : std::max<std::size_t>(1, workers - 1);
+
+        // Chunks are handed out round-robin across channels under one lock; chunks are coarse, so
+        // the lock is taken twice per batch_size orders.
+        std::mutex schedule_mutex;
+        std::size_t cursor = 0;
+        const auto claim = [&](std::size_t& lane, std::size_t& offset) {
+            std::lock_guard<std::mutex> lock(schedule_mutex);
+            for (std::size_t k = 0; k < lanes.size(); ++k) {
+                const std::size_t candidate = (cursor + k) % lanes.size();
+                Lane& entry = lanes[candidate];
+                if (entry.next < entry.indices->size() && entry.in_flight < per_channel) {
+                    lane = candidate;
+                    offset = entry.next;
+                    entry.next += batch_size;
+                    ++entry.in_flight;
+                    cursor = candidate + 1;
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // A worker leaves once nothing is claimable; a lane it skipped for being at its limit is
+        // finished by the workers holding it, which release and claim again.
+        const auto drain = [&] {
+            std::vector<const PayReq*> batch;
+            std::vector<PayResp> out;
+            std::size_t lane = 0;
+            std::size_t offset = 0;
+            while (claim(lane, offset)) {
+                const Lane& entry = lanes[lane];
+                const std::size_t* indices = entry.indices->data() + offset;
+                const std::size_t chunk = std::min(batch_size, entry.indices->size() - offset);
+                batch.clear();
+                for (std::size_t i = 0; i < chunk; ++i) {
+                    batch.push_back(&reqs[indices[i]].req);
+                }
+                if (out.size() < chunk) {
+                    out.resize(chunk);
+                }
+                std::size_t settled = 0;
+                std::string error;
+                try {
+                    withClient(channels_[entry.channel], [&](PaymentClient& client) {
+                        client.payBatch(batch.data(), batch.size(), out.data(), settled);
+                    });
+                    if (settled < chunk) {
+                        error = "payBatch stopped after " + std::to_string(settled) + " of " + std::to_string(chunk);
+                    }
+                } catch (const std::exception& ex) {
+                    error = ex.what();
+                }
+                for (std::size_t i = 0; i < chunk; ++i) {
+                    BatchPayResult& result = results[indices[i]];
+                    if (i < settled) {
+                        result.status = out[i].ok ? PayStatus::Ok : PayStatus::Declined;
+                        result.resp = std::move(out[i]);
+                    } else {
+                        result = {PayStatus::Failed, {false, PayMessage(error)}};
+                    }
+                }
+                std::lock_guard<std::mutex> lock(schedule_mutex);
+                --lanes[lane].in_flight;
+            }
+        };
+
+        std::vector<std::future<void>> helpers = batch_workers_.spawn(workers - 1, drain);
+        std::exception_ptr error;
+        try {
+            drain();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        for (auto& helper : helpers) {
+            try {
+                helper.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return results;
+    }
+
+    PoolStats poolStats(const std::string& channel) const {
+        const Channel& entry = channels_[resolve(channel).index];
+        if (entry.pool == nullptr) {
+            throw std::invalid_argument("No client pool for channel: " + channel);
+        }
+        return entry.pool->stats();
     }
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<PaymentClientFactory>> factories_;
+    struct Channel {
+        std::unique_ptr<PaymentClientFactory> factory;
+        std::unique_ptr<PaymentClientPool> pool;
+    };
+
+    template <typename Fn>
+    static auto withClient(Channel& channel, Fn fn) -> decltype(fn(std::declval<PaymentClient&>())) {
+        if (channel.pool != nullptr) {
+            const auto lease = channel.pool->checkout();
+            return fn(*lease);
+        }
+        const auto client = channel.factory->create();
+        return fn(*client);
+    }
+
+    std::unordered_map<std::string, std::uint32_t> handles_;
+    std::vector<Channel> channels_;
+    BatchWorkers batch_workers_;  // last: joined before the channels its tasks use
 };
 
-int main() {
+enum class StaticChannel : std::size_t { Alipay, Wechat, BankCard };
+
+class StaticPaymentRouter {
+public:
+    template <StaticChannel C>
+    PayResp pay(const PayReq& req) {
+        return std::get<static_cast<std::size_t>(C)>(clients_[static_cast<std::size_t>(C)]).pay(req);
+    }
+
+    PayResp pay(StaticChannel channel, const PayReq& req) {
+        return std::visit([&req](auto& client) { return client.pay(req); },
+                          clients_[static_cast<std::size_t>(channel)]);
+    }
+
+private:
+    using Client = std::variant<AlipayClient, WechatPayClient, BankCardPayClient>;
+
+    std::array<Client, 3> clients_{Client{std::in_place_index<0>}, Client{std::in_place_index<1>},
+                                   Client{std::in_place_index<2>}};
+};
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+double measurePaymentsPerSec(PaymentService& service, const std::string& channel, int threads) {
+    using clock = std::chrono::steady_clock;
+    constexpr int kPaymentsPerThread = 200'000;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    const auto start = clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&service, &channel] {
+            const PayReq req{"ORD-1001", 8800};
+            for (int i = 0; i < kPaymentsPerThread; ++i) {
+                doNotOptimize(service.pay(channel, req).ok);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return static_cast<double>(kPaymentsPerThread) * threads / seconds;
+}
+
+template <typename Pay>
+double measureNsPerPayment(Pay pay) {
+    using clock = std::chrono::steady_clock;
+    constexpr int kPayments = 1'000'000;
+
+    const PayReq req{"ORD-1001", 8800};
+    const auto start = clock::now();
+    for (int i = 0; i < kPayments; ++i) {
+        doNotOptimize(pay(i % 3, req).ok);
+    }
+    return std::chrono::duration<double, std::nano>(clock::now() - start).count() / kPayments;
+}
+
+void runDispatchBenchmark() {
     PaymentService service;
     service.registerFactory("alipay", std::make_unique<AlipayFactory>());
     service.registerFactory("wechat", std::make_unique<WechatPayFactory>());
+    service.registerFactory("bank_card", std::make_unique<BankCardPayFactory>());
+    StaticPaymentRouter router;
+
+    const std::array<std::string, 3> names{"alipay", "wechat", "bank_card"};
+    const std::array<ChannelHandle, 3> handles{service.resolve(names[0]), service.resolve(names[1]),
+                                               service.resolve(names[2])};
+    const std::array<StaticChannel, 3> statics{StaticChannel::Alipay, StaticChannel::Wechat,
+                                               StaticChannel::BankCard};
+
+    const double by_name = measureNsPerPayment(
+        [&](int i, const PayReq& req) { return service.pay(names[i], req); });
+    const double by_handle = measureNsPerPayment(
+        [&](int i, const PayReq& req) { return service.pay(handles[i], req); });
+    const double by_visit = measureNsPerPayment(
+        [&](int i, const PayReq& req) { return router.pay(statics[i], req); });
+    const double by_template = measureNsPerPayment([&](int, const PayReq& req) {
+        return router.pay<StaticChannel::Alipay>(req);
+    });
+
+    std::cout << "\nPer-call dispatch latency (ns/payment, channels rotated)\n";
+    std::cout << std::left << std::setw(34) << "string lookup + virtual" << std::fixed
+              << std::setprecision(1) << by_name << "\n";
+    std::cout << std::left << std::setw(34) << "ChannelHandle + virtual" << by_handle << "\n";
+    std::cout << std::left << std::setw(34) << "StaticChannel + std::visit" << by_visit << "\n";
+    std::cout << std::left << std::setw(34) << "pay<StaticChannel::Alipay>" << by_template << "\n";
+}
+
+class SimulatedGatewayClient final : public PaymentClient {
+public:
+    PayResp pay(const PayReq& req) override {
+        std::this_thread::sleep_for(kRoundTrip);
+        return {true, paidMessage("gateway", req)};
+    }
+
+    void payBatch(const PayReq* const* reqs, std::size_t count, PayResp* out, std::size_t& settled) override {
+        std::this_thread::sleep_for(kRoundTrip);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = {true, paidMessage("gateway", *reqs[i])};
+        }
+        settled = count;
+    }
+
+    static constexpr std::chrono::microseconds kRoundTrip{50};
+};
+
+class SimulatedGatewayFactory final : public PaymentClientFactory {
+public:
+    std::unique_ptr<PaymentClient> create() override { return std::make_unique<SimulatedGatewayClient>(); }
+};
+
+void runBatchBenchmark() {
+    using clock = std::chrono::steady_clock;
+    PaymentService service;
+    service.registerFactory("alipay", std::make_unique<AlipayFactory>());
+    service.registerFactory("wechat", std::make_unique<WechatPayFactory>(), 8);
+    service.registerFactory("gateway", std::make_unique<SimulatedGatewayFactory>());
+
+    std::cout << "\nSettlement throughput (orders/s)\n";
+    std::cout << std::left << std::setw(40) << "workload" << std::setw(16) << "one-at-a-time"
+              << "payBatch\n";
+    const auto run = [&](const char* label, const std::vector<std::string>& mix, std::size_t orders) {
+        std::vector<ChannelPayReq> reqs;
+        reqs.reserve(orders);
+        for (std::size_t i = 0; i < orders; ++i) {
+            reqs.push_back({mix[i % mix.size()], {"ORD-" + std::to_string(i), static_cast<int>(i % 10000)}});
+        }
+
+        auto start = clock::now();
+        for (const auto& item : reqs) {
+            doNotOptimize(service.pay(item.channel, item.req).ok);
+        }
+        const double loop_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        start = clock::now();
+        const auto results = service.payBatch(reqs.data(), reqs.size());
+        const double batch_seconds = std::chrono::duration<double>(clock::now() - start).count();
+        if (std::any_of(results.begin(), results.end(),
+                        [](const BatchPayResult& r) { return r.status != PayStatus::Ok; })) {
+            throw std::runtime_error("payBatch benchmark: unexpected failed order");
+        }
+        std::cout << std::left << std::setw(40) << label << std::setw(16) << std::fixed
+                  << std::setprecision(0) << orders / loop_seconds << orders / batch_seconds << "\n";
+    };
+    run("in-memory alipay + wechat", {"alipay", "wechat"}, 200'000);
+    run("alipay + gateway (50us round trip)", {"alipay", "gateway"}, 4'000);
+    std::cout << "(the loop drops each PayResp; payBatch keeps one result per order, so in-memory\n"
+              << " channels settle faster one at a time and payBatch pays off once there is a round trip)\n";
+}
+
+std::string legacyPaidMessage(const std::string& channel, const PayReq& req) {
+    return channel + " paid order=" + req.orderId + ", amount=" + std::to_string(req.amount);
+}
+
+void runFormattingBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr int kMessages = 1'000'000;
+    const PayReq req{"ORD-1001", 8800};
+    const std::string channel = "alipay";
+
+    std::uint64_t allocations = g_heap_allocations.load();
+    auto start = clock::now();
+    for (int i = 0; i < kMessages; ++i) {
+        doNotOptimize(legacyPaidMessage(channel, req).size());
+    }
+    const double legacy_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / kMessages;
+    const double legacy_allocs = static_cast<double>(g_heap_allocations.load() - allocations) / kMessages;
+
+    allocations = g_heap_allocations.load();
+    start = clock::now();
+    for (int i = 0; i < kMessages; ++i) {
+        doNotOptimize(paidMessage(channel, req).view().size());
+    }
+    const double inline_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / kMessages;
+    const double inline_allocs = static_cast<double>(g_heap_allocations.load() - allocations) / kMessages;
+
+    std::cout << "\nPayResp message formatting\n";
+    std::cout << std::left << std::setw(28) << "std::string concatenation" << std::fixed << std::setprecision(1)
+              << legacy_ns << " ns, " << std::setprecision(2) << legacy_allocs << " allocs/msg\n";
+    std::cout << std::left << std::setw(28) << "PayMessage + to_chars" << std::setprecision(1) << inline_ns
+              << " ns, " << std::setprecision(2) << inline_allocs << " allocs/msg\n";
+}
+
+void runPoolBenchmark() {
+    std::cout << "\nPayment throughput (Mpay/s)\n";
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(20) << "create() per call"
+              << std::setw(16) << "pooled" << "pool hits/misses/waits\n";
+    for (const int threads : {1, 4}) {
+        PaymentService service;
+        service.registerFactory("alipay", std::make_unique<AlipayFactory>());
+        service.registerFactory("alipay_pooled", std::make_unique<AlipayFactory>(), threads);
+        const double per_call = measurePaymentsPerSec(service, "alipay", threads);
+        const double pooled = measurePaymentsPerSec(service, "alipay_pooled", threads);
+        const PoolStats stats = service.poolStats("alipay_pooled");
+        std::cout << std::left << std::setw(10) << threads << std::setw(20) << std::fixed
+                  << std::setprecision(2) << per_call / 1e6 << std::setw(16) << pooled / 1e6
+                  << stats.hits << "/" << stats.misses << "/" << stats.waits << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    PaymentService service;
+    service.registerFactory("alipay", std::make_unique<AlipayFactory>());
+    service.registerFactory("wechat", std::make_unique<WechatPayFactory>(), 4);
 
     const PayReq req{"ORD-1001", 8800};
     std::cout << "Factory Method implementation\n";
@@ -99,5 +769,44 @@ int main() {
     service.registerFactory("bank_card", std::make_unique<BankCardPayFactory>());
     std::cout << "New channel added by registering a new factory; PaymentService unchanged\n";
     std::cout << service.pay("bank_card", req).msg << "\n";
+
+    for (int i = 0; i < 3; ++i) {
+        service.pay("wechat", req);
+    }
+    const PoolStats wechat = service.poolStats("wechat");
+    std::cout << "Pooled wechat clients: hits=" << wechat.hits << ", misses=" << wechat.misses
+              << ", waits=" << wechat.waits << "\n";
+
+    const ChannelHandle bank_card = service.resolve("bank_card");
+    StaticPaymentRouter router;
+    std::cout << "Resolved handle: " << service.pay(bank_card, req).msg << "\n";
+    std::cout << "Static route: " << router.pay(StaticChannel::Wechat, req).msg << "\n";
+
+    const ChannelHandle wechat_handle = service.resolve("wechat");
+    const std::uint64_t allocations_before = g_heap_allocations.load();
+    for (int i = 0; i < 1000; ++i) {
+        doNotOptimize(service.pay(wechat_handle, req).ok);
+    }
+    std::cout << "Heap allocations for 1000 pooled payments: "
+              << g_heap_allocations.load() - allocations_before << "\n";
+
+    const auto batch = service.payBatch({{"wechat", {"ORD-2001", 100}},
+                                         {"unionpay", {"ORD-2002", 200}},
+                                         {"alipay", {"ORD-2003", 300}}});
+    for (const auto& result : batch) {
+        std::cout << "Batch item: " << (result.status == PayStatus::Ok ? "OK " : "ERR ")
+                  << result.resp.msg << "\n";
+    }
+
+    const PayResp long_id = service.pay("alipay", PayReq{"ORD-" + std::string(100, '7'), 100});
+    std::cout << "Long order id: " << (long_id.ok ? "paid" : "failed") << ", " << long_id.msg.view().size()
+              << "-byte message " << (long_id.msg.inlined() ? "inline" : "moved to the heap") << "\n";
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        runPoolBenchmark();
+        runDispatchBenchmark();
+        runBatchBenchmark();
+        runFormattingBenchmark();
+    }
     return 0;
 }
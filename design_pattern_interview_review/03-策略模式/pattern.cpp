@@ -1,9 +1,39 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+std::atomic<std::uint64_t> g_heap_allocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
 
 struct RiskInput {
     int amount;
@@ -12,49 +42,854 @@ struct RiskInput {
     bool overseasIp;
 };
 
+enum class RiskVerdict : std::uint8_t { Pass = 0, ManualReview = 1, Reject = 2 };
+
+enum class RiskReason : std::uint8_t {
+    None,
+    TooManyFailedPays,
+    OverseasLargeAmount,
+    NewDeviceLargeAmount,
+    AboveVipLimit,
+    RecentFailedPays,
+};
+
+struct RiskDecision {
+    RiskVerdict verdict;
+    RiskReason reason;
+};
+
+const char* toString(RiskVerdict verdict) {
+    switch (verdict) {
+        case RiskVerdict::Pass:
+            return "PASS";
+        case RiskVerdict::ManualReview:
+            return "MANUAL_REVIEW";
+        case RiskVerdict::Reject:
+            return "REJECT";
+    }
+    return "UNKNOWN";
+}
+
+const char* toString(RiskReason reason) {
+    switch (reason) {
+        case RiskReason::None:
+            return "none";
+        case RiskReason::TooManyFailedPays:
+            return "too_many_failed_pays";
+        case RiskReason::OverseasLargeAmount:
+            return "overseas_large_amount";
+        case RiskReason::NewDeviceLargeAmount:
+            return "new_device_large_amount";
+        case RiskReason::AboveVipLimit:
+            return "above_vip_limit";
+        case RiskReason::RecentFailedPays:
+            return "recent_failed_pays";
+    }
+    return "unknown";
+}
+
+struct RiskColumns {
+    std::vector<std::int32_t> amount;
+    std::vector<std::uint8_t> newDevice;
+    std::vector<std::int32_t> failedPayCount;
+    std::vector<std::uint8_t> overseasIp;
+
+    std::size_t size() const { return amount.size(); }
+
+    RiskInput row(std::size_t i) const {
+        return RiskInput{amount[i], newDevice[i] != 0, failedPayCount[i], overseasIp[i] != 0};
+    }
+
+    void push_back(const RiskInput& in) {
+        amount.push_back(in.amount);
+        newDevice.push_back(in.newDevice ? 1 : 0);
+        failedPayCount.push_back(in.failedPayCount);
+        overseasIp.push_back(in.overseasIp ? 1 : 0);
+    }
+};
+
+template <typename Kernel>
+inline void forEachRowBlock(std::size_t n, Kernel kernel) {
+    constexpr std::size_t kBlock = 64;
+    std::size_t i = 0;
+    for (; i + kBlock <= n; i += kBlock) {
+        for (std::size_t j = 0; j < kBlock; ++j) {
+            kernel(i + j);
+        }
+    }
+    for (; i < n; ++i) {
+        kernel(i);
+    }
+}
+
+// Batch kernels stay out of line: GCC's -O2 cost model vectorises the fixed 64-row blocks only
+// while the __restrict parameters are visible, which inlining into the virtual caller loses.
+// Flag bytes are tested with != 0, like RiskColumns::row().
+__attribute__((noinline)) void normalTradeKernel(std::size_t n, const std::int32_t* __restrict amount,
+                                                 const std::int32_t* __restrict failed,
+                                                 const std::uint8_t* __restrict overseas,
+                                                 RiskVerdict* __restrict verdict) {
+    forEachRowBlock(n, [=](std::size_t i) {
+        const unsigned reject = (failed[i] >= 5) | ((overseas[i] != 0) & (amount[i] > 20000));
+        verdict[i] = static_cast<RiskVerdict>(reject << 1);
+    });
+}
+
+__attribute__((noinline)) void newDeviceKernel(std::size_t n, const std::int32_t* __restrict amount,
+                                               const std::uint8_t* __restrict new_device,
+                                               RiskVerdict* __restrict verdict) {
+    forEachRowBlock(n, [=](std::size_t i) {
+        verdict[i] = static_cast<RiskVerdict>((new_device[i] != 0) & (amount[i] > 5000));
+    });
+}
+
+__attribute__((noinline)) void vipFastPassKernel(std::size_t n, const std::int32_t* __restrict amount,
+                                                 const std::int32_t* __restrict failed,
+                                                 RiskVerdict* __restrict verdict) {
+    forEachRowBlock(n, [=](std::size_t i) {
+        verdict[i] = static_cast<RiskVerdict>((amount[i] > 50000) | (failed[i] > 1));
+    });
+}
+
 class RiskStrategy {
 public:
     virtual ~RiskStrategy() = default;
-    virtual std::string evaluate(const RiskInput& in) const = 0;
+    virtual RiskDecision evaluate(const RiskInput& in) const = 0;
+
+    virtual void evaluateBatch(const RiskColumns& in, RiskVerdict* out) const {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = evaluate(in.row(i)).verdict;
+        }
+    }
+
+    // Strategies that call out to a model or a remote service; fan-out runs them on the pool.
+    virtual bool expensive() const { return false; }
 };
 
 class NormalTradeStrategy final : public RiskStrategy {
 public:
-    std::string evaluate(const RiskInput& in) const override {
-        if (in.failedPayCount >= 5 || (in.overseasIp && in.amount > 20000)) {
-            return "REJECT";
+    RiskDecision evaluate(const RiskInput& in) const override {
+        if (in.failedPayCount >= 5) {
+            return {RiskVerdict::Reject, RiskReason::TooManyFailedPays};
+        }
+        if (in.overseasIp && in.amount > 20000) {
+            return {RiskVerdict::Reject, RiskReason::OverseasLargeAmount};
         }
-        return "PASS";
+        return {RiskVerdict::Pass, RiskReason::None};
+    }
+
+    void evaluateBatch(const RiskColumns& in, RiskVerdict* out) const override {
+        normalTradeKernel(in.size(), in.amount.data(), in.failedPayCount.data(), in.overseasIp.data(), out);
     }
 };
 
 class NewDeviceStrictStrategy final : public RiskStrategy {
 public:
-    std::string evaluate(const RiskInput& in) const override {
+    RiskDecision evaluate(const RiskInput& in) const override {
         if (in.newDevice && in.amount > 5000) {
-            return "MANUAL_REVIEW";
+            return {RiskVerdict::ManualReview, RiskReason::NewDeviceLargeAmount};
         }
-        return "PASS";
+        return {RiskVerdict::Pass, RiskReason::None};
+    }
+
+    void evaluateBatch(const RiskColumns& in, RiskVerdict* out) const override {
+        newDeviceKernel(in.size(), in.amount.data(), in.newDevice.data(), out);
     }
 };
 
 class VipFastPassStrategy final : public RiskStrategy {
 public:
-    std::string evaluate(const RiskInput& in) const override {
-        if (in.amount <= 50000 && in.failedPayCount <= 1) {
-            return "PASS";
+    RiskDecision evaluate(const RiskInput& in) const override {
+        if (in.amount > 50000) {
+            return {RiskVerdict::ManualReview, RiskReason::AboveVipLimit};
+        }
+        if (in.failedPayCount > 1) {
+            return {RiskVerdict::ManualReview, RiskReason::RecentFailedPays};
         }
-        return "MANUAL_REVIEW";
+        return {RiskVerdict::Pass, RiskReason::None};
+    }
+
+    void evaluateBatch(const RiskColumns& in, RiskVerdict* out) const override {
+        vipFastPassKernel(in.size(), in.amount.data(), in.failedPayCount.data(), out);
     }
 };
 
+struct RuleCondition {
+    std::uint8_t field;
+    std::uint8_t rule;
+    std::uint32_t lo;
+    std::uint32_t span;
+};
+
+struct DecisionTable {
+    static constexpr std::size_t kMaxRules = 63;
+
+    std::vector<RuleCondition> conditions;
+    std::vector<RiskDecision> decisions;  // one per rule, followed by the default
+
+    RiskDecision evaluate(const RiskInput& in) const {
+        const std::uint32_t fields[4] = {static_cast<std::uint32_t>(in.amount), in.newDevice,
+                                         static_cast<std::uint32_t>(in.failedPayCount), in.overseasIp};
+        std::uint64_t failed = 0;
+        for (const RuleCondition& cond : conditions) {
+            failed |= static_cast<std::uint64_t>(fields[cond.field] - cond.lo > cond.span) << cond.rule;
+        }
+        return decisions[__builtin_ctzll(~failed)];
+    }
+};
+
+class RuleCompiler {
+public:
+    static DecisionTable compile(const std::string& text) {
+        DecisionTable table;
+        RiskDecision fallback{RiskVerdict::Pass, RiskReason::None};
+        std::istringstream lines(text);
+        std::string line;
+        for (int line_no = 1; std::getline(lines, line); ++line_no) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream tokens(line);
+            std::vector<std::string> words;
+            for (std::string word; tokens >> word;) {
+                words.push_back(word);
+            }
+            if (!words.empty()) {
+                compileLine(words, line_no, table, fallback);
+            }
+        }
+        table.decisions.push_back(fallback);
+        return table;
+    }
+
+private:
+    enum Field : std::uint8_t { kAmount, kNewDevice, kFailedPayCount, kOverseasIp };
+
+    static void compileLine(const std::vector<std::string>& words, int line_no, DecisionTable& table,
+                            RiskDecision& fallback) {
+        std::size_t pos = 0;
+        const bool is_default = words[pos] == "default";
+        if (is_default) {
+            ++pos;
+        }
+        RiskDecision decision{parseVerdict(expect(words, pos++, line_no), line_no), RiskReason::None};
+        if (pos < words.size() && words[pos] != "when") {
+            decision.reason = parseReason(words[pos++], line_no);
+        }
+        if (is_default) {
+            if (pos != words.size()) {
+                fail(line_no, "default rule takes no conditions");
+            }
+            fallback = decision;
+            return;
+        }
+        if (expect(words, pos++, line_no) != "when") {
+            fail(line_no, "expected 'when'");
+        }
+
+        if (table.decisions.size() == DecisionTable::kMaxRules) {
+            fail(line_no, "too many rules");
+        }
+        const auto rule = static_cast<std::uint8_t>(table.decisions.size());
+        for (;;) {
+            RuleCondition cond = parseCondition(words, pos, line_no);
+            cond.rule = rule;
+            table.conditions.push_back(cond);
+            if (pos == words.size()) {
+                break;
+            }
+            if (words[pos++] != "and") {
+                fail(line_no, "expected 'and' between conditions");
+            }
+        }
+        table.decisions.push_back(decision);
+    }
+
+    static RuleCondition parseCondition(const std::vector<std::string>& words, std::size_t& pos, int line_no) {
+        constexpr std::int64_t kMin = std::numeric_limits<std::int32_t>::min();
+        constexpr std::int64_t kMax = std::numeric_limits<std::int32_t>::max();
+
+        const bool negated = expect(words, pos, line_no) == "not";
+        if (negated) {
+            ++pos;
+        }
+        const std::string& name = expect(words, pos++, line_no);
+        if (name == "newDevice" || name == "overseasIp") {
+            const std::int64_t value = negated ? 0 : 1;
+            return RuleCondition{name == "newDevice" ? kNewDevice : kOverseasIp, 0,
+                                 static_cast<std::uint32_t>(value), 0};
+        }
+        if (negated) {
+            fail(line_no, "'not' only applies to newDevice and overseasIp");
+        }
+
+        std::uint8_t field = kAmount;
+        if (name == "failedPayCount") {
+            field = kFailedPayCount;
+        } else if (name != "amount") {
+            fail(line_no, "unknown field '" + name + "'");
+        }
+        const std::string& op = expect(words, pos++, line_no);
+        const std::string& literal = expect(words, pos++, line_no);
+        std::int64_t value = 0;
+        try {
+            value = std::stoll(literal);
+        } catch (const std::exception&) {
+            fail(line_no, "expected an integer, got '" + literal + "'");
+        }
+        value = std::min(std::max(value, kMin - 1), kMax + 1);  // keeps value +/- 1 below from overflowing
+
+        std::int64_t lo = kMin;
+        std::int64_t hi = kMax;
+        if (op == ">") {
+            lo = value + 1;
+        } else if (op == ">=") {
+            lo = value;
+        } else if (op == "<") {
+            hi = value - 1;
+        } else if (op == "<=") {
+            hi = value;
+        } else if (op == "==") {
+            lo = hi = value;
+        } else {
+            fail(line_no, "unsupported operator '" + op + "'");
+        }
+        // Fields are int32: bounds outside the domain are clamped to it instead of wrapping.
+        if (lo > hi || lo > kMax || hi < kMin) {
+            fail(line_no, "condition can never match");
+        }
+        lo = std::max(lo, kMin);
+        hi = std::min(hi, kMax);
+        return RuleCondition{field, 0, static_cast<std::uint32_t>(lo), static_cast<std::uint32_t>(hi - lo)};
+    }
+
+    static RiskVerdict parseVerdict(const std::string& word, int line_no) {
+        for (const RiskVerdict verdict : {RiskVerdict::Pass, RiskVerdict::ManualReview, RiskVerdict::Reject}) {
+            if (word == toString(verdict)) {
+                return verdict;
+            }
+        }
+        fail(line_no, "unknown verdict '" + word + "'");
+    }
+
+    static RiskReason parseReason(const std::string& word, int line_no) {
+        for (const RiskReason reason :
+             {RiskReason::None, RiskReason::TooManyFailedPays, RiskReason::OverseasLargeAmount,
+              RiskReason::NewDeviceLargeAmount, RiskReason::AboveVipLimit, RiskReason::RecentFailedPays}) {
+            if (word == toString(reason)) {
+                return reason;
+            }
+        }
+        fail(line_no, "unknown reason '" + word + "'");
+    }
+
+    static const std::string& expect(const std::vector<std::string>& words, std::size_t pos, int line_no) {
+        if (pos >= words.size()) {
+            fail(line_no, "unexpected end of rule");
+        }
+        return words[pos];
+    }
+
+    [[noreturn]] static void fail(int line_no, const std::string& message) {
+        throw std::invalid_argument("Risk rule line " + std::to_string(line_no) + ": " + message);
+    }
+};
+
+// Small dense ids for live threads, reused once a thread exits. Past kMaxThreads live threads,
+// current() returns kOverflowSlot rather than failing; callers must treat that id as shared.
+class ThreadSlots {
+public:
+    static constexpr int kMaxThreads = 256;
+    static constexpr int kOverflowSlot = -1;
+
+    static int current() {
+        thread_local const Lease lease;
+        return lease.slot;
+    }
+
+private:
+    struct Lease {
+        Lease() : slot(acquire()) {}
+        ~Lease() { release(slot); }
+        int slot;
+    };
+
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<int>& freeSlots() {
+        static std::vector<int> slots;
+        return slots;
+    }
+
+    static int acquire() {
+        static int next_slot = 0;
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& slots = freeSlots();
+        if (!slots.empty()) {
+            const int slot = slots.back();
+            slots.pop_back();
+            return slot;
+        }
+        if (next_slot == kMaxThreads) {
+            return kOverflowSlot;
+        }
+        return next_slot++;
+    }
+
+    static void release(int slot) {
+        if (slot == kOverflowSlot) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex());
+        freeSlots().push_back(slot);
+    }
+};
+
+// Threads on the overflow slot pin through a shared reader count instead of an epoch; while any
+// of them is pinned, oldestActive() reports 0 and nothing retired can be reclaimed.
+class EpochDomain {
+public:
+    static constexpr std::uint64_t kIdle = ~std::uint64_t{0};
+
+    class Guard {
+    public:
+        Guard() = default;
+        Guard(Guard&& other) noexcept
+            : slot_(std::exchange(other.slot_, nullptr)), shared_(std::exchange(other.shared_, nullptr)) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            if (slot_ != nullptr) {
+                slot_->store(kIdle, std::memory_order_release);
+            }
+            if (shared_ != nullptr) {
+                shared_->unpinShared();
+            }
+        }
+
+    private:
+        friend class EpochDomain;
+        std::atomic<std::uint64_t>* slot_ = nullptr;
+        EpochDomain* shared_ = nullptr;
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    ~EpochDomain() {
+        for (const auto& retired : retired_) {
+            retired.destroy(retired.ptr);
+        }
+    }
+
+    Guard pin() {
+        Guard guard;
+        const int slot = ThreadSlots::current();
+        if (slot == ThreadSlots::kOverflowSlot) {
+            shared_readers_.fetch_add(1);
+            guard.shared_ = this;
+            return guard;
+        }
+        auto& announced = slots_[slot].epoch;
+        if (announced.load(std::memory_order_relaxed) != kIdle) {
+            return guard;
+        }
+        announced.store(global_epoch_.load());
+        guard.slot_ = &announced;
+        return guard;
+    }
+
+    std::uint64_t advance() { return global_epoch_.fetch_add(1); }
+
+    std::uint64_t oldestActive() const {
+        if (shared_readers_.load() != 0) {
+            return 0;
+        }
+        std::uint64_t oldest = kIdle;
+        for (const auto& slot : slots_) {
+            oldest = std::min(oldest, slot.epoch.load());
+        }
+        return oldest;
+    }
+
+    // Frees ptr once no reader pinned before this call can still hold it. Writers may retire
+    // concurrently: the engine and every compiled rule table share one domain.
+    template <typename T>
+    void retire(const T* ptr) {
+        std::lock_guard<std::mutex> lock(retire_mutex_);
+        retired_.push_back(Retired{ptr, [](const void* p) { delete static_cast<const T*>(p); }, advance()});
+        reclaimLocked();
+    }
+
+    // Frees everything no pinned reader can reach; returns how many objects are still waiting.
+    std::size_t reclaim() {
+        std::lock_guard<std::mutex> lock(retire_mutex_);
+        return reclaimLocked();
+    }
+
+    std::size_t pendingReclaim() const {
+        std::lock_guard<std::mutex> lock(retire_mutex_);
+        return retired_.size();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{kIdle};
+    };
+
+    struct Retired {
+        const void* ptr;
+        void (*destroy)(const void*);
+        std::uint64_t epoch;
+    };
+
+    std::size_t reclaimLocked() {
+        const std::uint64_t oldest = oldestActive();
+        auto keep = retired_.begin();
+        for (auto it = retired_.begin(); it != retired_.end(); ++it) {
+            if (it->epoch < oldest) {
+                it->destroy(it->ptr);
+            } else {
+                *keep++ = *it;
+            }
+        }
+        retired_.erase(keep, retired_.end());
+        return retired_.size();
+    }
+
+    void unpinShared() { shared_readers_.fetch_sub(1, std::memory_order_release); }
+
+    std::atomic<std::uint64_t> global_epoch_{1};
+    std::atomic<std::uint64_t> shared_readers_{0};
+    Slot slots_[ThreadSlots::kMaxThreads];
+    mutable std::mutex retire_mutex_;
+    std::vector<Retired> retired_;
+};
+
+// One domain for everything the risk engine publishes, so the pin RiskEngine takes around a call
+// also covers the compiled rule table the strategy reads.
+EpochDomain& riskEpochs() {
+    static EpochDomain domain;
+    return domain;
+}
+
+class CompiledRuleStrategy final : public RiskStrategy {
+public:
+    explicit CompiledRuleStrategy(const std::string& rules) { reload(rules); }
+
+    CompiledRuleStrategy(const CompiledRuleStrategy&) = delete;
+    CompiledRuleStrategy& operator=(const CompiledRuleStrategy&) = delete;
+
+    ~CompiledRuleStrategy() override { delete current_.load(); }
+
+    // Callers are pinned on riskEpochs(): RiskEngine pins around every call, and code holding the
+    // strategy directly pins once around its loop. A per-decision pin cost a third of throughput.
+    RiskDecision evaluate(const RiskInput& in) const override {
+        return current_.load(std::memory_order_acquire)->evaluate(in);
+    }
+
+    void evaluateBatch(const RiskColumns& in, RiskVerdict* out) const override {
+        const DecisionTable& table = *current_.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = table.evaluate(in.row(i)).verdict;
+        }
+    }
+
+    // Replaced tables are freed once no reader pinned before the swap is still using them.
+    void reload(const std::string& rules) {
+        auto table = std::make_unique<const DecisionTable>(RuleCompiler::compile(rules));
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        const DecisionTable* old = current_.exchange(table.release(), std::memory_order_acq_rel);
+        if (old == nullptr) {
+            return;
+        }
+        riskEpochs().retire(old);
+    }
+
+private:
+    std::atomic<const DecisionTable*> current_{nullptr};
+    std::mutex reload_mutex_;
+};
+
+const char* const kNormalTradeRules = R"(
+REJECT too_many_failed_pays when failedPayCount >= 5
+REJECT overseas_large_amount when overseasIp and amount > 20000
+default PASS
+)";
+
+const char* const kVipFastPassRules = R"(
+MANUAL_REVIEW above_vip_limit when amount > 50000
+MANUAL_REVIEW recent_failed_pays when failedPayCount > 1
+default PASS
+)";
+
+class TaskPool {
+public:
+    explicit TaskPool(std::size_t threads) : threads_(threads) {}
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (workers_.empty()) {
+                for (std::size_t i = 0; i < threads_; ++i) {
+                    workers_.emplace_back([this] { run(); });
+                }
+            }
+            tasks_.push_back(std::move(task));
+        }
+        ready_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    const std::size_t threads_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
+
+class SceneSet {
+public:
+    std::size_t size() const { return strategies_.size(); }
+    const std::string& name(std::size_t i) const { return names_[i]; }
+
+private:
+    friend class RiskEngine;
+    std::vector<std::string> names_;
+    std::vector<std::shared_ptr<const RiskStrategy>> strategies_;
+};
+
+struct SceneOutcome {
+    std::size_t scene;  // index into the SceneSet
+    RiskDecision decision;
+    std::chrono::nanoseconds latency;
+};
+
+struct CombinedDecision {
+    RiskDecision decision;  // most severe verdict; reason from the first scene that produced it
+    std::vector<SceneOutcome> scenes;  // evaluated scenes only, in set order
+    bool short_circuited = false;
+};
+
+struct FanOutOptions {
+    bool parallel_expensive = true;
+};
+
 class RiskEngine {
+public:
+    RiskEngine() : strategies_(new StrategyMap()) {}
+
+    RiskEngine(const RiskEngine&) = delete;
+    RiskEngine& operator=(const RiskEngine&) = delete;
+
+    ~RiskEngine() { delete strategies_.load(); }
+
+    void registerStrategy(const std::string& scene, std::unique_ptr<RiskStrategy> strategy) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        auto next = std::make_unique<StrategyMap>(*strategies_.load());
+        (*next)[scene] = std::shared_ptr<const RiskStrategy>(std::move(strategy));
+        const StrategyMap* old = strategies_.exchange(next.release());
+        riskEpochs().retire(old);
+    }
+
+    RiskDecision evaluate(const std::string& scene, const RiskInput& in) const {
+        const EpochDomain::Guard guard = riskEpochs().pin();
+        return find(scene).evaluate(in);
+    }
+
+    void evaluateBatch(const std::string& scene, const RiskColumns& in, std::vector<RiskVerdict>& out) const {
+        const EpochDomain::Guard guard = riskEpochs().pin();
+        const RiskStrategy& strategy = find(scene);
+        out.resize(in.size());
+        strategy.evaluateBatch(in, out.data());
+    }
+
+    // Looks every scene up once; the set keeps its strategies alive across re-registration.
+    SceneSet resolveScenes(const std::vector<std::string>& scenes) const {
+        const EpochDomain::Guard guard = riskEpochs().pin();
+        const StrategyMap& strategies = *strategies_.load();
+        SceneSet set;
+        set.names_ = scenes;
+        set.strategies_.reserve(scenes.size());
+        for (const auto& scene : scenes) {
+            const auto it = strategies.find(scene);
+            if (it == strategies.end()) {
+                throw std::invalid_argument("Unknown risk scene: " + scene);
+            }
+            set.strategies_.push_back(it->second);
+        }
+        return set;
+    }
+
+    // Scenes are combined in order and evaluation stops at the first REJECT. Expensive strategies
+    // start on the pool up front; results of scenes past a REJECT are simply never collected.
+    CombinedDecision evaluateAll(const SceneSet& set, const RiskInput& in, const FanOutOptions& options = {}) const {
+        std::vector<std::future<SceneOutcome>> pending(set.size());
+        if (options.parallel_expensive) {
+            for (std::size_t i = 0; i < set.size(); ++i) {
+                if (!set.strategies_[i]->expensive()) {
+                    continue;
+                }
+                auto task = std::make_shared<std::packaged_task<SceneOutcome()>>(
+                    [strategy = set.strategies_[i], in, i] { return timedEvaluate(*strategy, in, i); });
+                pending[i] = task->get_future();
+                pool_.submit([task] { (*task)(); });
+            }
+        }
+
+        CombinedDecision combined{{RiskVerdict::Pass, RiskReason::None}, {}};
+        combined.scenes.reserve(set.size());
+        for (std::size_t i = 0; i < set.size(); ++i) {
+            const SceneOutcome outcome =
+                pending[i].valid() ? pending[i].get() : timedEvaluate(*set.strategies_[i], in, i);
+            combined.scenes.push_back(outcome);
+            if (outcome.decision.verdict > combined.decision.verdict) {
+                combined.decision = outcome.decision;
+            }
+            if (outcome.decision.verdict == RiskVerdict::Reject) {
+                combined.short_circuited = i + 1 < set.size();
+                break;
+            }
+        }
+        return combined;
+    }
+
+private:
+    using StrategyMap = std::unordered_map<std::string, std::shared_ptr<const RiskStrategy>>;
+
+    static SceneOutcome timedEvaluate(const RiskStrategy& strategy, const RiskInput& in, std::size_t scene) {
+        const EpochDomain::Guard guard = riskEpochs().pin();
+        const auto start = std::chrono::steady_clock::now();
+        const RiskDecision decision = strategy.evaluate(in);
+        return {scene, decision, std::chrono::steady_clock::now() - start};
+    }
+
+    const RiskStrategy& find(const std::string& scene) const {
+        const StrategyMap& strategies = *strategies_.load();
+        const auto it = strategies.find(scene);
+        if (it == strategies.end()) {
+            throw std::invalid_argument("Unknown risk scene: " + scene);
+        }
+        return *it->second;
+    }
+
+    std::atomic<const StrategyMap*> strategies_;
+    std::mutex writer_mutex_;
+    mutable TaskPool pool_{4};
+};
+
+RiskColumns makeRandomColumns(std::size_t rows) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> amount(1, 80000);
+    std::uniform_int_distribution<std::int32_t> failed(0, 7);
+    std::bernoulli_distribution flag(0.2);
+    std::uniform_int_distribution<int> set_byte(1, 255);  // any non-zero byte means true
+
+    RiskColumns columns;
+    columns.amount.resize(rows);
+    columns.newDevice.resize(rows);
+    columns.failedPayCount.resize(rows);
+    columns.overseasIp.resize(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        columns.amount[i] = amount(rng);
+        columns.newDevice[i] = flag(rng) ? static_cast<std::uint8_t>(set_byte(rng)) : 0;
+        columns.failedPayCount[i] = failed(rng);
+        columns.overseasIp[i] = flag(rng) ? static_cast<std::uint8_t>(set_byte(rng)) : 0;
+    }
+    return columns;
+}
+
+// Every batch kernel must agree with the scalar path row for row, including flag bytes other than 0/1.
+void checkBatchMatchesScalar(const RiskEngine& engine) {
+    const RiskColumns columns = makeRandomColumns(1000);
+    std::vector<RiskVerdict> batch;
+    for (const char* scene : {"normal_trade", "new_device_strict", "vip_fast_pass"}) {
+        engine.evaluateBatch(scene, columns, batch);
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (batch[i] != engine.evaluate(scene, columns.row(i)).verdict) {
+                throw std::logic_error(std::string("Batch verdict differs from scalar path for ") + scene +
+                                       " at row " + std::to_string(i));
+            }
+        }
+    }
+}
+
+void runBatchBenchmark(const RiskEngine& engine, std::size_t rows) {
+    using clock = std::chrono::steady_clock;
+    const RiskColumns columns = makeRandomColumns(rows);
+    std::vector<RiskVerdict> scalar(rows);
+    std::vector<RiskVerdict> batch;
+
+    std::cout << "\nRe-scoring " << rows << " rows (Mrows/s)\n";
+    std::cout << std::left << std::setw(22) << "scene" << std::setw(18) << "scalar per-row"
+              << "columnar batch\n";
+    for (const char* scene : {"normal_trade", "new_device_strict", "vip_fast_pass"}) {
+        auto start = clock::now();
+        for (std::size_t i = 0; i < rows; ++i) {
+            scalar[i] = engine.evaluate(scene, columns.row(i)).verdict;
+        }
+        const double scalar_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        start = clock::now();
+        engine.evaluateBatch(scene, columns, batch);
+        const double batch_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (batch != scalar) {
+            throw std::logic_error(std::string("Batch verdicts differ from scalar path for ") + scene);
+        }
+        std::cout << std::left << std::setw(22) << scene << std::setw(18) << std::fixed
+                  << std::setprecision(1) << rows / scalar_seconds / 1e6 << rows / batch_seconds / 1e6
+                  << "\n";
+    }
+}
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class MutexGuardedRiskEngine {
 public:
     void registerStrategy(const std::string& scene, std::unique_ptr<RiskStrategy> strategy) {
+        std::lock_guard<std::mutex> lock(mutex_);
         strategies_[scene] = std::move(strategy);
     }
 
-    std::string evaluate(const std::string& scene, const RiskInput& in) const {
+    RiskDecision evaluate(const std::string& scene, const RiskInput& in) const {
+        std::lock_guard<std::mutex> lock(mutex_);
         const auto it = strategies_.find(scene);
         if (it == strategies_.end()) {
             throw std::invalid_argument("Unknown risk scene: " + scene);
@@ -63,20 +898,295 @@ public:
     }
 
 private:
+    mutable std::mutex mutex_;
     std::unordered_map<std::string, std::unique_ptr<RiskStrategy>> strategies_;
 };
 
-int main() {
+template <typename Engine>
+double stressRegistry(Engine& engine, int readers, int writers) {
+    using clock = std::chrono::steady_clock;
+    constexpr auto kDuration = std::chrono::milliseconds(300);
+    const std::vector<std::string> scenes{"normal_trade", "new_device_strict", "vip_fast_pass", "churn_0",
+                                          "churn_1", "churn_2", "churn_3"};
+    for (const auto& scene : scenes) {
+        engine.registerStrategy(scene, std::make_unique<NormalTradeStrategy>());
+    }
+    const RiskColumns columns = makeRandomColumns(1024);
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> decisions{0};
+    std::atomic<std::uint64_t> replacements{0};
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            std::uint64_t count = 0;
+            std::uint64_t rejected = 0;
+            for (std::size_t i = r; !stop.load(std::memory_order_relaxed); ++i) {
+                const RiskDecision decision = engine.evaluate(scenes[i % scenes.size()], columns.row(i % 1024));
+                rejected += decision.verdict == RiskVerdict::Reject;
+                ++count;
+            }
+            doNotOptimize(rejected);
+            decisions += count;
+        });
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            for (std::size_t i = w; !stop.load(std::memory_order_relaxed); ++i) {
+                const std::string& scene = scenes[3 + i % 4];
+                if (i % 2 == 0) {
+                    engine.registerStrategy(scene, std::make_unique<VipFastPassStrategy>());
+                } else {
+                    engine.registerStrategy(scene, std::make_unique<CompiledRuleStrategy>(kNormalTradeRules));
+                }
+                ++replacements;
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+
+    const auto start = clock::now();
+    std::this_thread::sleep_for(kDuration);
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    if (replacements.load() == 0) {
+        throw std::logic_error("Registry stress test made no replacements");
+    }
+    return decisions.load() / seconds;
+}
+
+void runRegistryStress() {
+    std::cout << "\nRegistry stress: 32 readers, 2 writers replacing scenes every 200us (Mdecisions/s)\n";
+    RiskEngine lock_free;
+    MutexGuardedRiskEngine locked;
+    const double cow = stressRegistry(lock_free, 32, 2);
+    const double mutex = stressRegistry(locked, 32, 2);
+    std::cout << std::left << std::setw(26) << "mutex-guarded map" << std::fixed << std::setprecision(1)
+              << mutex / 1e6 << "\n";
+    std::cout << std::left << std::setw(26) << "copy-on-write + epochs" << cow / 1e6 << "\n";
+}
+
+void runRuleBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kRows = 1'000'000;
+    const RiskColumns columns = makeRandomColumns(kRows);
+
+    std::cout << "\nCompiled rules vs. hand-written strategies (Mdecisions/s)\n";
+    std::cout << std::left << std::setw(22) << "scene" << std::setw(18) << "virtual subclass"
+              << "compiled rules\n";
+    const auto compare = [&](const char* scene, const RiskStrategy& handwritten, const RiskStrategy& compiled) {
+        std::vector<RiskDecision> expected(kRows);
+        auto start = clock::now();
+        for (std::size_t i = 0; i < kRows; ++i) {
+            expected[i] = handwritten.evaluate(columns.row(i));
+        }
+        const double handwritten_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        std::vector<RiskDecision> actual(kRows);
+        start = clock::now();
+        {
+            const EpochDomain::Guard guard = riskEpochs().pin();
+            for (std::size_t i = 0; i < kRows; ++i) {
+                actual[i] = compiled.evaluate(columns.row(i));
+            }
+        }
+        const double compiled_seconds = std::chrono::duration<double>(clock::now() - start).count();
+        const bool same = std::equal(expected.begin(), expected.end(), actual.begin(),
+                                     [](const RiskDecision& a, const RiskDecision& b) {
+                                         return a.verdict == b.verdict && a.reason == b.reason;
+                                     });
+        if (!same) {
+            throw std::logic_error(std::string("Compiled rules disagree with strategy for ") + scene);
+        }
+        std::cout << std::left << std::setw(22) << scene << std::setw(18) << std::fixed << std::setprecision(1)
+                  << kRows / handwritten_seconds / 1e6 << kRows / compiled_seconds / 1e6 << "\n";
+    };
+
+    const std::unique_ptr<const RiskStrategy> normal = std::make_unique<NormalTradeStrategy>();
+    const std::unique_ptr<const RiskStrategy> vip = std::make_unique<VipFastPassStrategy>();
+    compare("normal_trade", *normal, CompiledRuleStrategy(kNormalTradeRules));
+    compare("vip_fast_pass", *vip, CompiledRuleStrategy(kVipFastPassRules));
+}
+
+// Stands in for a model-scoring call: a fixed remote round trip, then a score threshold.
+class ModelScoreStrategy final : public RiskStrategy {
+public:
+    ModelScoreStrategy(std::chrono::microseconds rtt, std::int32_t review_above)
+        : rtt_(rtt), review_above_(review_above) {}
+
+    RiskDecision evaluate(const RiskInput& in) const override {
+        std::this_thread::sleep_for(rtt_);
+        if (in.amount > review_above_) {
+            return {RiskVerdict::ManualReview, RiskReason::AboveVipLimit};
+        }
+        return {RiskVerdict::Pass, RiskReason::None};
+    }
+
+    bool expensive() const override { return true; }
+
+private:
+    std::chrono::microseconds rtt_;
+    std::int32_t review_above_;
+};
+
+void runFanOutBenchmark(RiskEngine& engine) {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kDecisions = 2000;
+    engine.registerStrategy("device_model", std::make_unique<ModelScoreStrategy>(std::chrono::microseconds(200), 40000));
+    engine.registerStrategy("amount_model", std::make_unique<ModelScoreStrategy>(std::chrono::microseconds(200), 60000));
+    const std::vector<std::string> scenes{"normal_trade", "new_device_strict", "device_model", "amount_model"};
+    const SceneSet set = engine.resolveScenes(scenes);
+    const RiskColumns columns = makeRandomColumns(kDecisions);
+
+    const auto percentiles = [](std::vector<double>& us) {
+        std::sort(us.begin(), us.end());
+        return std::make_pair(us[us.size() / 2], us[us.size() * 99 / 100]);
+    };
+    const auto report = [&](const char* mode, std::vector<double>& us) {
+        const auto p = percentiles(us);
+        std::cout << std::left << std::setw(30) << mode << std::setw(10) << std::fixed << std::setprecision(1)
+                  << p.first << p.second << "\n";
+    };
+
+    std::vector<double> latency_us(kDecisions);
+    std::cout << "\nCombined decision over " << scenes.size() << " scenes, 2 model calls of 200us (latency us)\n";
+    std::cout << std::left << std::setw(30) << "mode" << std::setw(10) << "p50" << "p99\n";
+
+    for (std::size_t i = 0; i < kDecisions; ++i) {
+        const auto start = clock::now();
+        RiskVerdict worst = RiskVerdict::Pass;
+        for (const auto& scene : scenes) {
+            worst = std::max(worst, engine.evaluate(scene, columns.row(i)).verdict);
+        }
+        doNotOptimize(worst);
+        latency_us[i] = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    }
+    report("per-scene evaluate, all", latency_us);
+
+    const auto measure = [&](const char* mode, const FanOutOptions& options) {
+        std::size_t short_circuited = 0;
+        for (std::size_t i = 0; i < kDecisions; ++i) {
+            const auto start = clock::now();
+            const CombinedDecision combined = engine.evaluateAll(set, columns.row(i), options);
+            latency_us[i] = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+            short_circuited += combined.short_circuited;
+        }
+        report(mode, latency_us);
+        return short_circuited;
+    };
+    const std::size_t sequential_skips = measure("fan-out, sequential", FanOutOptions{false});
+    measure("fan-out, parallel models", FanOutOptions{true});
+    std::cout << sequential_skips << "/" << kDecisions << " decisions short-circuited on REJECT\n";
+}
+
+void runDecisionBenchmark(const RiskEngine& engine) {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kDecisions = 1'000'000;
+    const RiskColumns columns = makeRandomColumns(4096);
+
+    std::uint64_t allocations = g_heap_allocations.load();
+    auto start = clock::now();
+    std::size_t rejected = 0;
+    for (std::size_t i = 0; i < kDecisions; ++i) {
+        const std::string verdict = toString(engine.evaluate("normal_trade", columns.row(i % 4096)).verdict);
+        rejected += verdict == "REJECT";
+    }
+    const double string_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    const double string_allocs = static_cast<double>(g_heap_allocations.load() - allocations) / kDecisions;
+    doNotOptimize(rejected);
+
+    allocations = g_heap_allocations.load();
+    start = clock::now();
+    rejected = 0;
+    for (std::size_t i = 0; i < kDecisions; ++i) {
+        rejected += engine.evaluate("normal_trade", columns.row(i % 4096)).verdict == RiskVerdict::Reject;
+    }
+    const double enum_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    const double enum_allocs = static_cast<double>(g_heap_allocations.load() - allocations) / kDecisions;
+    doNotOptimize(rejected);
+
+    std::cout << "\nnormal_trade decisions (string verdict = old std::string API + downstream compare)\n";
+    std::cout << std::left << std::setw(22) << "string verdict" << std::fixed << std::setprecision(1)
+              << kDecisions / string_seconds / 1e6 << " Mdecisions/s, " << std::setprecision(2)
+              << string_allocs << " allocs/decision\n";
+    std::cout << std::left << std::setw(22) << "RiskDecision enum" << std::setprecision(1)
+              << kDecisions / enum_seconds / 1e6 << " Mdecisions/s, " << std::setprecision(2) << enum_allocs
+              << " allocs/decision\n";
+}
+
+int main(int argc, char** argv) {
     RiskEngine engine;
     engine.registerStrategy("normal_trade", std::make_unique<NormalTradeStrategy>());
     engine.registerStrategy("new_device_strict", std::make_unique<NewDeviceStrictStrategy>());
 
     const RiskInput input{6800, true, 1, false};
     std::cout << "Strategy implementation\n";
-    std::cout << "normal_trade => " << engine.evaluate("normal_trade", input) << "\n";
+    std::cout << "normal_trade => " << toString(engine.evaluate("normal_trade", input).verdict) << "\n";
 
     engine.registerStrategy("vip_fast_pass", std::make_unique<VipFastPassStrategy>());
     std::cout << "New scene added by registration; RiskEngine unchanged\n";
-    std::cout << "vip_fast_pass => " << engine.evaluate("vip_fast_pass", input) << "\n";
+    std::cout << "vip_fast_pass => " << toString(engine.evaluate("vip_fast_pass", input).verdict) << "\n";
+
+    const RiskDecision strict = engine.evaluate("new_device_strict", input);
+    std::cout << "new_device_strict => " << toString(strict.verdict) << " (" << toString(strict.reason)
+              << ")\n";
+
+    auto rules = std::make_unique<CompiledRuleStrategy>(kNormalTradeRules);
+    CompiledRuleStrategy& normal_rules = *rules;
+    engine.registerStrategy("normal_trade_rules", std::move(rules));
+    const RiskInput overseas{30000, false, 0, true};
+    std::cout << "normal_trade_rules => " << toString(engine.evaluate("normal_trade_rules", overseas).verdict);
+    normal_rules.reload("MANUAL_REVIEW overseas_large_amount when overseasIp and amount > 20000\ndefault PASS");
+    std::cout << ", after hot reload => " << toString(engine.evaluate("normal_trade_rules", overseas).verdict)
+              << "\n";
+    for (int i = 0; i < 1000; ++i) {
+        normal_rules.reload(kNormalTradeRules);
+    }
+    std::cout << "Replaced tables still awaiting reclamation after 1000 reloads: " << riskEpochs().pendingReclaim()
+              << "\n";
+    try {
+        CompiledRuleStrategy truncated("REJECT when amount > 5 and");
+    } catch (const std::invalid_argument& e) {
+        std::cout << "Rejected rule text: " << e.what() << "\n";
+    }
+
+    RiskColumns columns;
+    columns.push_back(input);
+    columns.push_back(RiskInput{30000, false, 0, true});
+    columns.push_back(RiskInput{9000, true, 0, false});
+    columns.newDevice.back() = 2;  // flag bytes other than 1 still mean true
+    std::vector<RiskVerdict> verdicts;
+    engine.evaluateBatch("normal_trade", columns, verdicts);
+    std::cout << "Columnar normal_trade verdict codes:";
+    for (const RiskVerdict verdict : verdicts) {
+        std::cout << " " << static_cast<int>(verdict);
+    }
+    std::vector<RiskVerdict> strict_verdicts;
+    engine.evaluateBatch("new_device_strict", columns, strict_verdicts);
+    std::cout << ", new_device_strict with flag byte 2 => " << toString(strict_verdicts.back()) << "\n";
+    checkBatchMatchesScalar(engine);
+
+    const SceneSet checkout = engine.resolveScenes({"normal_trade", "new_device_strict", "vip_fast_pass"});
+    const CombinedDecision combined = engine.evaluateAll(checkout, RiskInput{30000, true, 0, false});
+    std::cout << "Fan-out checkout => " << toString(combined.decision.verdict) << " ("
+              << toString(combined.decision.reason) << "), evaluated " << combined.scenes.size() << "/"
+              << checkout.size() << " scenes:";
+    for (const SceneOutcome& outcome : combined.scenes) {
+        std::cout << " " << checkout.name(outcome.scene) << "=" << toString(outcome.decision.verdict) << " "
+                  << outcome.latency.count() << "ns";
+    }
+    std::cout << "\n";
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        const std::size_t rows = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+        runBatchBenchmark(engine, rows);
+        runDecisionBenchmark(engine);
+        runRuleBenchmark();
+        runRegistryStress();
+        runFanOutBenchmark(engine);
+    }
     return 0;
 }
@@ -1,11 +1,129 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+std::atomic<std::uint64_t> g_heap_allocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Process-lifetime storage for strings too long to keep inline. Each distinct string is stored once
+// and never freed, so a pointer into it can sit in a trivially copyable event.
+std::string_view internString(std::string_view text) {
+    static std::mutex mutex;
+    static auto* strings = new std::unordered_set<std::string>();
+    std::lock_guard<std::mutex> lock(mutex);
+    return *strings->emplace(text).first;
+}
+
+// Inline string so an event is one flat, trivially copyable block. Longer input is interned and
+// the block holds a pointer to it instead; unused bytes stay zero because events are persisted as
+// raw bytes, and the log writes interned text out alongside the event.
+template <std::size_t Capacity>
+class FixedString {
+    static_assert(Capacity < 255, "size is stored in one byte, 255 marks an interned string");
+    static_assert(Capacity >= sizeof(const char*) + sizeof(std::uint32_t), "room for an interned reference");
+
+public:
+    FixedString() = default;
+    FixedString(std::string_view text) { assign(text); }
+    FixedString(const std::string& text) { assign(text); }
+    FixedString(const char* text) { assign(text); }
+
+    std::string_view view() const {
+        if (!interned()) {
+            return std::string_view(buf_, size_);
+        }
+        const char* data = nullptr;
+        std::uint32_t size = 0;
+        std::memcpy(&data, buf_, sizeof(data));
+        std::memcpy(&size, buf_ + sizeof(data), sizeof(size));
+        return std::string_view(data, size);
+    }
+
+    bool interned() const { return size_ == kInterned; }
+
+    // The same string without its process-local pointer: what the log persists. Only the length
+    // survives, so a reader must reattach() the text it stored next to the event.
+    FixedString detached() const {
+        FixedString copy = *this;
+        if (interned()) {
+            std::memset(copy.buf_, 0, sizeof(const char*));
+        }
+        return copy;
+    }
+
+    std::size_t size() const { return view().size(); }
+
+    void reattach(std::string_view text) { *this = FixedString(text); }
+
+    friend std::ostream& operator<<(std::ostream& os, const FixedString& str) { return os << str.view(); }
+
+private:
+    static constexpr std::uint8_t kInterned = 255;
+
+    void assign(std::string_view text) {
+        if (text.size() <= Capacity) {
+            size_ = static_cast<std::uint8_t>(text.size());
+            std::memcpy(buf_, text.data(), size_);
+            return;
+        }
+        if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("FixedString: string too long");
+        }
+        const std::string_view stored = internString(text);
+        const char* data = stored.data();
+        const auto size = static_cast<std::uint32_t>(stored.size());
+        std::memcpy(buf_, &data, sizeof(data));
+        std::memcpy(buf_ + sizeof(data), &size, sizeof(size));
+        size_ = kInterned;
+    }
+
+    char buf_[Capacity] = {};
+    std::uint8_t size_ = 0;
+};
+
+// Sized for a prefixed UUID (e.g. "ORD-" + 36 characters) in either id; longer ids are interned.
 struct OrderCreatedEvent {
-    std::string order_id;
-    std::string user_id;
+    FixedString<47> order_id;
+    FixedString<47> user_id;
     double amount;
 };
 
@@ -13,6 +131,14 @@ class OrderObserver {
 public:
     virtual ~OrderObserver() = default;
     virtual void onOrderCreated(const OrderCreatedEvent& event) = 0;
+
+    // Observers that write to a store override both; async lanes then hand them whole batches.
+    virtual bool supportsBatch() const { return false; }
+    virtual void onOrderCreatedBatch(const OrderCreatedEvent* events, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            onOrderCreated(events[i]);
+        }
+    }
 };
 
 class EmailObserver final : public OrderObserver {
@@ -34,6 +160,20 @@ public:
     void onOrderCreated(const OrderCreatedEvent& event) override {
         std::cout << "Add points for " << event.user_id << ", amount=" << event.amount << "\n";
     }
+
+    bool supportsBatch() const override { return true; }
+
+    void onOrderCreatedBatch(const OrderCreatedEvent* events, std::size_t count) override {
+        if (count == 1) {
+            onOrderCreated(events[0]);
+            return;
+        }
+        double amount = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            amount += events[i].amount;
+        }
+        std::cout << "Add points for " << count << " orders in one write, amount=" << amount << "\n";
+    }
 };
 
 class PushObserver final : public OrderObserver {
@@ -43,18 +183,1273 @@ public:
     }
 };
 
+// Bounded lock-free MPMC queue (Vyukov): each cell carries a sequence number that tells
+// producers and consumers whose turn it is, so head and tail only need a CAS each.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(std::size_t capacity) : cells_(new Cell[capacity]), mask_(capacity - 1) {
+        if (capacity < 2 || (capacity & mask_) != 0) {
+            throw std::invalid_argument("MpmcRing capacity must be a power of two");
+        }
+        for (std::size_t i = 0; i < capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Moves from value only when the push succeeds.
+    bool tryPush(T& value) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty() const {
+        const std::size_t pos = head_.load(std::memory_order_acquire);
+        return cells_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    const std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+};
+
+enum class Backpressure { Block, Drop, Spill };
+
+struct AsyncPublishOptions {
+    std::size_t queue_capacity = 1024;  // per observer
+    Backpressure backpressure = Backpressure::Block;
+    std::size_t event_pool_size = 4096;  // events in flight before falling back to the heap
+    std::size_t max_batch = 64;  // batch-capable observers only
+    std::chrono::microseconds max_linger{0};  // how long a partial batch may wait for more events
+};
+
+struct AsyncPublishStats {
+    std::uint64_t enqueued = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t spilled = 0;
+    std::uint64_t pool_overflows = 0;
+};
+
+// An event shared by every lane it was fanned out to; the last lane to finish returns it.
+struct PooledEvent {
+    OrderCreatedEvent event;
+    std::int64_t enqueued_ns = 0;
+    std::atomic<std::uint32_t> pending{0};
+    std::atomic<std::uint32_t> next;
+    bool from_heap = false;
+};
+
+// Fixed slab of events with a tagged Treiber free list; heap allocation only when it runs dry.
+class EventSlab {
+public:
+    explicit EventSlab(std::size_t capacity)
+        : capacity_(static_cast<std::uint32_t>(capacity)), slots_(new PooledEvent[capacity]) {
+        if (capacity == 0 || capacity >= kNil) {
+            throw std::invalid_argument("EventSlab: invalid capacity");
+        }
+        for (std::uint32_t slot = capacity_; slot-- > 0;) {
+            push(slot);
+        }
+    }
+
+    PooledEvent* acquire(const OrderCreatedEvent& event, std::int64_t enqueued_ns, std::uint32_t fanout) {
+        std::uint32_t slot = kNil;
+        PooledEvent* pooled = nullptr;
+        if (tryPop(slot)) {
+            pooled = &slots_[slot];
+        } else {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            pooled = new PooledEvent();
+            pooled->from_heap = true;
+        }
+        pooled->event = event;
+        pooled->enqueued_ns = enqueued_ns;
+        pooled->pending.store(fanout, std::memory_order_relaxed);
+        return pooled;
+    }
+
+    void release(PooledEvent* pooled) {
+        if (pooled->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (pooled->from_heap) {
+            delete pooled;
+        } else {
+            push(static_cast<std::uint32_t>(pooled - slots_.get()));
+        }
+    }
+
+    std::uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::uint32_t kNil = 0xffffffffu;
+
+    void push(std::uint32_t slot) {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        std::uint64_t desired = 0;
+        do {
+            slots_[slot].next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            desired = (((head >> 32) + 1) << 32) | slot;
+        } while (!head_.compare_exchange_weak(head, desired, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    bool tryPop(std::uint32_t& slot) {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            const auto top = static_cast<std::uint32_t>(head);
+            if (top == kNil) {
+                return false;
+            }
+            const std::uint64_t next = slots_[top].next.load(std::memory_order_relaxed);
+            const std::uint64_t desired = (((head >> 32) + 1) << 32) | next;
+            if (head_.compare_exchange_weak(head, desired, std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                slot = top;
+                return true;
+            }
+        }
+    }
+
+    std::uint32_t capacity_;
+    std::unique_ptr<PooledEvent[]> slots_;
+    std::atomic<std::uint64_t> head_{kNil};
+    std::atomic<std::uint64_t> overflows_{0};
+};
+
+// max_lag is measured from enqueue to the start of delivery; current_lag is the age of the oldest
+// event still queued or in delivery.
+struct ObserverQueueStats {
+    std::uint64_t depth = 0;
+    std::uint64_t delivered = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t spilled = 0;
+    std::chrono::microseconds current_lag{0};
+    std::chrono::microseconds max_lag{0};
+};
+
+struct EventLogOptions {
+    std::size_t segment_bytes = std::size_t{64} << 20;
+    // 0 syncs on every append; otherwise a flusher thread syncs once per window and appenders
+    // wait for the sync that covers their record.
+    std::chrono::microseconds group_commit_window{1000};
+};
+
+// Memory-mapped, append-only log of OrderCreatedEvent records split into fixed-size segment
+// files named after their first sequence number. Sequences start at 1.
+class OrderEventLog {
+public:
+    OrderEventLog(const std::string& directory, const EventLogOptions& options = {})
+        : directory_(directory), options_(options) {
+        if (options_.segment_bytes < kMinRecordSize) {
+            throw std::invalid_argument("OrderEventLog: segment smaller than one record");
+        }
+        std::filesystem::create_directories(directory_);
+        recover();
+        preparer_ = std::thread([this] { runPreparer(); });
+        if (options_.group_commit_window.count() > 0) {
+            flusher_ = std::thread([this] { runFlusher(); });
+        }
+    }
+
+    OrderEventLog(const OrderEventLog&) = delete;
+    OrderEventLog& operator=(const OrderEventLog&) = delete;
+
+    // A destructor cannot propagate a failed final sync, so it only reports it; call close() first
+    // to handle the error.
+    ~OrderEventLog() {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    // Stops the flusher, syncs the remaining records and unmaps the log. Throws if that sync, or an
+    // earlier background one, failed. Idempotent; append() fails afterwards.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                return;
+            }
+            closed_ = true;
+            stopping_ = true;
+        }
+        flush_wake_.notify_all();
+        spare_wanted_.notify_all();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+        if (preparer_.joinable()) {
+            preparer_.join();
+        }
+        std::exception_ptr error = flush_error_;
+        try {
+            flushOnce();
+        } catch (...) {
+            error = error ? error : std::current_exception();
+        }
+        // An append that raced close() may still be inside flushOnce() with a copy of active_.
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Segment& segment : sealed_) {
+            unmap(segment);
+        }
+        sealed_.clear();
+        unmap(active_);
+        active_ = Segment();
+        if (spare_.base != nullptr) {
+            unmap(spare_);
+            spare_ = Segment();
+            ::unlink(sparePath().c_str());
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Returns the record's sequence once it is on disk.
+    std::uint64_t append(const OrderCreatedEvent& event) {
+        // Interned ids are stored as text after the event bytes; the event keeps only their length.
+        OrderCreatedEvent stored = event;
+        stored.order_id = event.order_id.detached();
+        stored.user_id = event.user_id.detached();
+        const std::string_view order_text = event.order_id.interned() ? event.order_id.view() : std::string_view();
+        const std::string_view user_text = event.user_id.interned() ? event.user_id.view() : std::string_view();
+        const std::size_t length = sizeof(stored) + order_text.size() + user_text.size();
+        const std::size_t record_size = sizeof(RecordHeader) + length;
+        if (record_size > options_.segment_bytes) {
+            throw std::length_error("OrderEventLog: record of " + std::to_string(record_size) +
+                                    " bytes does not fit a segment");
+        }
+
+        std::uint64_t sequence = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                throw std::logic_error("OrderEventLog: append after close");
+            }
+            if (flush_error_) {
+                std::rethrow_exception(flush_error_);
+            }
+            if (active_.written + record_size > active_.size) {
+                rollOver();
+            }
+            sequence = next_sequence_++;
+            char* record = active_.base + active_.written;
+            char* body = record + sizeof(RecordHeader);
+            std::memcpy(body, &stored, sizeof(stored));
+            order_text.copy(body + sizeof(stored), order_text.size());
+            user_text.copy(body + sizeof(stored) + order_text.size(), user_text.size());
+            const RecordHeader header{sequence, static_cast<std::uint32_t>(length), checksum(sequence, body, length)};
+            std::memcpy(record, &header, sizeof(header));
+            active_.written += record_size;
+            active_.last_sequence = sequence;
+        }
+
+        if (options_.group_commit_window.count() == 0) {
+            flushOnce();
+        } else {
+            std::unique_lock<std::mutex> lock(mutex_);
+            durable_changed_.wait(lock, [&] { return durable_sequence_ >= sequence || flush_error_; });
+            if (durable_sequence_ < sequence) {
+                std::rethrow_exception(flush_error_);
+            }
+        }
+        return sequence;
+    }
+
+    // Calls fn for every durable record with sequence >= from; returns the sequence to resume at.
+    std::uint64_t replay(std::uint64_t from,
+                         const std::function<void(std::uint64_t, const OrderCreatedEvent&)>& fn) const {
+        std::vector<std::uint64_t> starts;
+        std::uint64_t durable = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            starts = segment_starts_;
+            durable = durable_sequence_;
+        }
+        std::uint64_t next = from;
+        for (std::size_t i = 0; i < starts.size() && next <= durable; ++i) {
+            if (i + 1 < starts.size() && starts[i + 1] <= from) {
+                continue;
+            }
+            const Segment segment = openSegment(starts[i], false);
+            scan(segment, [&](std::uint64_t sequence, const OrderCreatedEvent& event) {
+                if (sequence > durable) {
+                    return false;
+                }
+                if (sequence >= from) {
+                    fn(sequence, event);
+                    next = sequence + 1;
+                }
+                return true;
+            });
+            unmap(segment);
+        }
+        return next;
+    }
+
+    std::uint64_t replay(std::uint64_t from, OrderObserver& observer) const {
+        return replay(from, [&observer](std::uint64_t, const OrderCreatedEvent& event) {
+            observer.onOrderCreated(event);
+        });
+    }
+
+    std::uint64_t durableSequence() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return durable_sequence_;
+    }
+
+    std::size_t segmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return segment_starts_.size();
+    }
+
+private:
+    struct RecordHeader {
+        std::uint64_t sequence;
+        std::uint32_t length;
+        std::uint32_t checksum;
+    };
+
+    static_assert(std::is_trivially_copyable<OrderCreatedEvent>::value, "events are logged as raw bytes");
+    static constexpr std::size_t kMinRecordSize = sizeof(RecordHeader) + sizeof(OrderCreatedEvent);
+
+    struct Segment {
+        int fd = -1;
+        char* base = nullptr;
+        std::size_t size = 0;
+        std::size_t written = 0;
+        std::size_t flushed = 0;
+        std::uint64_t last_sequence = 0;
+    };
+
+    static std::uint32_t checksum(std::uint64_t sequence, const char* body, std::size_t length) {
+        std::uint64_t hash = 14695981039346656037ull ^ sequence;
+        const auto* bytes = reinterpret_cast<const unsigned char*>(body);
+        for (std::size_t i = 0; i < length; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+    }
+
+    [[noreturn]] static void fail(const std::string& what) {
+        throw std::runtime_error("OrderEventLog: " + what + ": " + std::strerror(errno));
+    }
+
+    std::string segmentPath(std::uint64_t first_sequence) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%020llu.log", static_cast<unsigned long long>(first_sequence));
+        return (std::filesystem::path(directory_) / name).string();
+    }
+
+    Segment openSegment(std::uint64_t first_sequence, bool writable) const {
+        const std::string path = segmentPath(first_sequence);
+        Segment segment;
+        segment.fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+        if (segment.fd < 0) {
+            fail("open " + path);
+        }
+        struct stat info {};
+        if (::fstat(segment.fd, &info) != 0) {
+            fail("stat " + path);
+        }
+        segment.size = static_cast<std::size_t>(info.st_size);
+        if (writable && segment.size == 0) {
+            allocate(segment, path);
+            syncDirectory();
+        }
+        map(segment, path, writable);
+        return segment;
+    }
+
+    // Reserves the blocks up front, so a full disk fails here rather than as SIGBUS on a later
+    // store into the mapping, and appends never change metadata.
+    void allocate(Segment& segment, const std::string& path) const {
+        const int rc = ::posix_fallocate(segment.fd, 0, static_cast<off_t>(options_.segment_bytes));
+        if (rc != 0) {
+            errno = rc;
+            fail("allocate " + path);
+        }
+        if (::fsync(segment.fd) != 0) {
+            fail("fsync " + path);
+        }
+        segment.size = options_.segment_bytes;
+    }
+
+    static void map(Segment& segment, const std::string& path, bool writable) {
+        void* base = ::mmap(nullptr, segment.size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                            segment.fd, 0);
+        if (base == MAP_FAILED) {
+            fail("mmap " + path);
+        }
+        segment.base = static_cast<char*>(base);
+    }
+
+    std::string sparePath() const { return (std::filesystem::path(directory_) / "spare.tmp").string(); }
+
+    // Allocated and mapped off the append path; rollOver() only has to rename it.
+    Segment prepareSpare() const {
+        const std::string path = sparePath();
+        Segment segment;
+        segment.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (segment.fd < 0) {
+            fail("open " + path);
+        }
+        try {
+            allocate(segment, path);
+            map(segment, path, true);
+        } catch (...) {
+            unmap(segment);
+            throw;
+        }
+        return segment;
+    }
+
+    // Caller holds mutex_. The rename is made durable by the next flush, before any record in the
+    // new segment is reported durable. Without a spare ready it falls back to allocating inline.
+    void rollOver() {
+        sealed_.push_back(active_);
+        if (spare_.base != nullptr) {
+            const std::string path = segmentPath(next_sequence_);
+            if (::rename(sparePath().c_str(), path.c_str()) != 0) {
+                sealed_.pop_back();
+                fail("rename " + path);
+            }
+            active_ = spare_;
+            spare_ = Segment();
+            directory_dirty_ = true;
+            spare_wanted_.notify_one();
+        } else {
+            active_ = openSegment(next_sequence_, true);
+        }
+        segment_starts_.push_back(next_sequence_);
+    }
+
+    static void unmap(const Segment& segment) {
+        if (segment.base != nullptr) {
+            ::munmap(segment.base, segment.size);
+        }
+        if (segment.fd >= 0) {
+            ::close(segment.fd);
+        }
+    }
+
+    void syncDirectory() const {
+        const int fd = ::open(directory_.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // Visits valid records from the start of a segment; stops at the first empty or torn one.
+    template <typename Visitor>
+    static std::size_t scan(const Segment& segment, Visitor visit) {
+        std::size_t offset = 0;
+        while (offset + kMinRecordSize <= segment.size) {
+            RecordHeader header;
+            std::memcpy(&header, segment.base + offset, sizeof(header));
+            const char* body = segment.base + offset + sizeof(header);
+            if (header.sequence == 0 || header.length < sizeof(OrderCreatedEvent) ||
+                header.length > segment.size - offset - sizeof(header) ||
+                header.checksum != checksum(header.sequence, body, header.length)) {
+                break;
+            }
+            OrderCreatedEvent event;
+            std::memcpy(&event, body, sizeof(event));
+            if (!reattach(event, body + sizeof(event), header.length - sizeof(event)) || !visit(header.sequence, event)) {
+                break;
+            }
+            offset += sizeof(header) + header.length;
+        }
+        return offset;
+    }
+
+    // Points the event's interned ids at the text stored after it; false if the text does not add up.
+    static bool reattach(OrderCreatedEvent& event, const char* text, std::size_t length) {
+        for (auto* id : {&event.order_id, &event.user_id}) {
+            if (!id->interned()) {
+                continue;
+            }
+            const std::size_t size = id->size();
+            if (size > length) {
+                return false;
+            }
+            id->reattach(std::string_view(text, size));
+            text += size;
+            length -= size;
+        }
+        return length == 0;
+    }
+
+    // Reopens the newest segment and continues after its last valid record.
+    void recover() {
+        for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+            if (entry.path().extension() == ".log") {
+                segment_starts_.push_back(std::stoull(entry.path().stem().string()));
+            }
+        }
+        std::sort(segment_starts_.begin(), segment_starts_.end());
+        if (segment_starts_.empty()) {
+            segment_starts_.push_back(1);
+        }
+        active_ = openSegment(segment_starts_.back(), true);
+        next_sequence_ = segment_starts_.back();
+        active_.written = scan(active_, [&](std::uint64_t sequence, const OrderCreatedEvent&) {
+            if (sequence != next_sequence_) {
+                return false;
+            }
+            ++next_sequence_;
+            return true;
+        });
+        active_.flushed = active_.written;
+        active_.last_sequence = next_sequence_ - 1;
+        durable_sequence_ = active_.last_sequence;
+    }
+
+    static void syncRange(const Segment& segment, std::size_t from, std::size_t to) {
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        if (from >= to) {
+            return;
+        }
+        const std::size_t start = from / page * page;
+        if (::msync(segment.base + start, to - start, MS_SYNC) != 0) {
+            fail("msync");
+        }
+    }
+
+    // One group commit: syncs sealed segments and the active tail, then publishes the new
+    // durable sequence. Only one flush runs at a time; appends continue meanwhile.
+    void flushOnce() {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::vector<Segment> sealed;
+        Segment active;
+        bool renamed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sealed.swap(sealed_);
+            active = active_;
+            std::swap(renamed, directory_dirty_);
+        }
+        if (renamed) {
+            syncDirectory();
+        }
+        for (const Segment& segment : sealed) {
+            syncRange(segment, segment.flushed, segment.written);
+            unmap(segment);
+        }
+        syncRange(active, active.flushed, active.written);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_.base == active.base) {
+                active_.flushed = std::max(active_.flushed, active.written);
+            } else {
+                // Rotated while syncing: the sealed copy already covers this range.
+                for (Segment& segment : sealed_) {
+                    if (segment.base == active.base) {
+                        segment.flushed = std::max(segment.flushed, active.written);
+                    }
+                }
+            }
+            durable_sequence_ = std::max(durable_sequence_, active.last_sequence);
+        }
+        durable_changed_.notify_all();
+    }
+
+    void runFlusher() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            flush_wake_.wait_for(lock, options_.group_commit_window);
+            if (active_.last_sequence == durable_sequence_ && sealed_.empty()) {
+                continue;
+            }
+            lock.unlock();
+            try {
+                flushOnce();
+            } catch (...) {
+                // Fail the waiting appenders instead of letting the exception end the process.
+                lock.lock();
+                flush_error_ = std::current_exception();
+                durable_changed_.notify_all();
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    // Keeps one spare segment ready. A failure is not fatal: rollOver() then allocates inline and
+    // the preparer tries again at the next rollover.
+    void runPreparer() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            spare_wanted_.wait(lock, [&] { return stopping_ || spare_.base == nullptr; });
+            if (stopping_) {
+                break;
+            }
+            const std::size_t segments = segment_starts_.size();
+            lock.unlock();
+            Segment spare;
+            try {
+                spare = prepareSpare();
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+            }
+            lock.lock();
+            if (spare.base == nullptr) {
+                spare_wanted_.wait(lock, [&] { return stopping_ || segment_starts_.size() != segments; });
+                continue;
+            }
+            spare_ = spare;
+        }
+    }
+
+    const std::string directory_;
+    const EventLogOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable durable_changed_;
+    std::condition_variable flush_wake_;
+    std::condition_variable spare_wanted_;
+    Segment active_;
+    Segment spare_;                // preallocated next segment, not yet named
+    std::vector<Segment> sealed_;  // rotated out, unmapped by the next flush
+    std::vector<std::uint64_t> segment_starts_;
+    std::uint64_t next_sequence_ = 1;
+    std::uint64_t durable_sequence_ = 0;
+    std::exception_ptr flush_error_;  // set once by the flusher; sticky
+    bool directory_dirty_ = false;    // a spare was renamed in since the last flush
+    bool stopping_ = false;
+    bool closed_ = false;
+
+    std::mutex flush_mutex_;
+    std::thread flusher_;
+    std::thread preparer_;
+};
+
+// Small dense ids for live threads, reused once a thread exits. Past kMaxThreads live threads,
+// current() returns kOverflowSlot rather than failing; callers must treat that id as shared.
+class ThreadSlots {
+public:
+    static constexpr int kMaxThreads = 256;
+    static constexpr int kOverflowSlot = -1;
+
+    static int current() {
+        thread_local const Lease lease;
+        return lease.slot;
+    }
+
+private:
+    struct Lease {
+        Lease() : slot(acquire()) {}
+        ~Lease() { release(slot); }
+        int slot;
+    };
+
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<int>& freeSlots() {
+        static std::vector<int> slots;
+        return slots;
+    }
+
+    static int acquire() {
+        static int next_slot = 0;
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& slots = freeSlots();
+        if (!slots.empty()) {
+            const int slot = slots.back();
+            slots.pop_back();
+            return slot;
+        }
+        if (next_slot == kMaxThreads) {
+            return kOverflowSlot;
+        }
+        return next_slot++;
+    }
+
+    static void release(int slot) {
+        if (slot == kOverflowSlot) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex());
+        freeSlots().push_back(slot);
+    }
+};
+
+// Threads on the overflow slot pin through a shared reader count instead of an epoch; while any
+// of them is pinned, oldestActive() reports 0 and nothing retired can be reclaimed.
+class EpochDomain {
+public:
+    static constexpr std::uint64_t kIdle = ~std::uint64_t{0};
+
+    class Guard {
+    public:
+        Guard() = default;
+        Guard(Guard&& other) noexcept
+            : slot_(std::exchange(other.slot_, nullptr)), shared_(std::exchange(other.shared_, nullptr)) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            if (slot_ != nullptr) {
+                slot_->store(kIdle, std::memory_order_release);
+            }
+            if (shared_ != nullptr) {
+                shared_->unpinShared();
+            }
+        }
+
+    private:
+        friend class EpochDomain;
+        std::atomic<std::uint64_t>* slot_ = nullptr;
+        EpochDomain* shared_ = nullptr;
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    Guard pin() {
+        Guard guard;
+        const int slot = ThreadSlots::current();
+        if (slot == ThreadSlots::kOverflowSlot) {
+            shared_readers_.fetch_add(1);
+            sharedPins().push_back(this);
+            guard.shared_ = this;
+            return guard;
+        }
+        auto& announced = slots_[slot].epoch;
+        if (announced.load(std::memory_order_relaxed) != kIdle) {
+            return guard;
+        }
+        announced.store(global_epoch_.load());
+        guard.slot_ = &announced;
+        return guard;
+    }
+
+    bool pinnedByCurrentThread() const {
+        const int slot = ThreadSlots::current();
+        if (slot == ThreadSlots::kOverflowSlot) {
+            const auto& pins = sharedPins();
+            return std::find(pins.begin(), pins.end(), this) != pins.end();
+        }
+        return slots_[slot].epoch.load(std::memory_order_relaxed) != kIdle;
+    }
+
+    std::uint64_t advance() { return global_epoch_.fetch_add(1); }
+
+    std::uint64_t oldestActive() const {
+        if (shared_readers_.load() != 0) {
+            return 0;
+        }
+        std::uint64_t oldest = kIdle;
+        for (const auto& slot : slots_) {
+            oldest = std::min(oldest, slot.epoch.load());
+        }
+        return oldest;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{kIdle};
+    };
+
+    static std::vector<const EpochDomain*>& sharedPins() {
+        thread_local std::vector<const EpochDomain*> pins;
+        return pins;
+    }
+
+    void unpinShared() {
+        auto& pins = sharedPins();
+        pins.erase(std::find(pins.rbegin(), pins.rend(), this).base() - 1);
+        shared_readers_.fetch_sub(1, std::memory_order_release);
+    }
+
+    std::atomic<std::uint64_t> global_epoch_{1};
+    std::atomic<std::uint64_t> shared_readers_{0};
+    Slot slots_[ThreadSlots::kMaxThreads];
+};
+
+using SubscriptionId = std::uint64_t;
+
 class OrderPublisher {
 public:
-    void subscribe(std::shared_ptr<OrderObserver> observer) { observers_.push_back(std::move(observer)); }
+    OrderPublisher() : list_(new SubscriberList()) {}
+    OrderPublisher(const OrderPublisher&) = delete;
+    OrderPublisher& operator=(const OrderPublisher&) = delete;
+
+    ~OrderPublisher() {
+        stopAsync();
+        delete list_.load();
+        for (auto& retired : retired_) {
+            delete retired.list;
+        }
+    }
+
+    // Writers copy the subscriber list and swap it in; publishers never wait on them.
+    SubscriptionId subscribe(std::shared_ptr<OrderObserver> observer) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        Subscriber subscriber{next_id_++, std::move(observer), nullptr};
+        if (slab_ != nullptr) {
+            subscriber.lane = startLane(subscriber.observer.get());
+        }
+        subscribers_.push_back(std::move(subscriber));
+        publishList();
+        return subscribers_.back().id;
+    }
+
+    // Does not wait for publishers: a publish already in flight may still deliver to the observer,
+    // so the publisher keeps it (and its lane) alive until no reader can reach it.
+    bool unsubscribe(SubscriptionId id) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        const auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
+                                     [id](const Subscriber& subscriber) { return subscriber.id == id; });
+        if (it == subscribers_.end()) {
+            return false;
+        }
+        Subscriber removed = std::move(*it);
+        subscribers_.erase(it);
+        publishList(std::move(removed));
+        return true;
+    }
+
+    // Every observer gets its own ring and worker, so a slow observer only grows its own
+    // backlog and still sees events in the order a given thread published them.
+    void startAsync(const AsyncPublishOptions& options = {}) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (slab_ != nullptr) {
+            throw std::logic_error("OrderPublisher: async publishing already running");
+        }
+        if (options.max_batch == 0) {
+            throw std::invalid_argument("OrderPublisher: max_batch must be positive");
+        }
+        options_ = options;
+        slab_ = std::make_unique<EventSlab>(options.event_pool_size);
+        for (auto& subscriber : subscribers_) {
+            subscriber.lane = startLane(subscriber.observer.get());
+        }
+        publishList();
+    }
+
+    // Delivers everything already accepted, then returns to synchronous publishing.
+    void stopAsync() {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (slab_ == nullptr) {
+            return;
+        }
+        std::vector<std::unique_ptr<Lane>> lanes;
+        for (auto& subscriber : subscribers_) {
+            lanes.push_back(std::move(subscriber.lane));
+        }
+        waitForReaders(publishList());
+        reclaim();
+        for (auto& lane : lanes) {
+            stopLane(*lane);
+        }
+        stats_.pool_overflows += slab_->overflows();
+        slab_.reset();
+    }
+
+    // Durable mode: publish() appends each event to the log (waiting for its group commit) before
+    // any observer sees it. Pass nullptr to detach; returns once no publish still uses the old log.
+    void attachLog(OrderEventLog* log) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        log_ = log;
+        waitForReaders(publishList());
+    }
+
+    AsyncPublishStats asyncStats() const {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        AsyncPublishStats stats = stats_;
+        for (const auto& subscriber : subscribers_) {
+            if (subscriber.lane != nullptr) {
+                addLaneStats(stats, *subscriber.lane);
+            }
+        }
+        if (slab_ != nullptr) {
+            stats.pool_overflows += slab_->overflows();
+        }
+        return stats;
+    }
+
+    // One entry per observer in subscription order; empty while publishing synchronously.
+    std::vector<ObserverQueueStats> observerStats() const {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        const std::int64_t now = nowNs();
+        std::vector<ObserverQueueStats> all;
+        for (const auto& subscriber : subscribers_) {
+            if (subscriber.lane == nullptr) {
+                continue;
+            }
+            const Lane& lane = *subscriber.lane;
+            ObserverQueueStats stats;
+            stats.delivered = lane.delivered.load();
+            stats.batches = lane.batches.load();
+            const std::uint64_t enqueued = lane.enqueued.load();
+            stats.depth = enqueued > stats.delivered ? enqueued - stats.delivered : 0;
+            stats.dropped = lane.dropped.load();
+            stats.spilled = lane.spilled.load();
+            if (stats.depth != 0) {
+                const std::int64_t head = lane.enqueue_ns[stats.delivered & lane.enqueue_ns_mask].load(
+                    std::memory_order_relaxed);
+                stats.current_lag = std::chrono::microseconds((now - head) / 1000);
+            }
+            stats.max_lag = std::chrono::microseconds(lane.max_lag_ns.load() / 1000);
+            all.push_back(stats);
+        }
+        return all;
+    }
 
+    // The publish path takes no lock, touches no refcounts and, while the slab has room, allocates
+    // nothing: it reads an immutable subscriber list under an epoch pin and calls raw pointers.
     void publish(const OrderCreatedEvent& event) {
-        for (const auto& observer : observers_) {
-            observer->onOrderCreated(event);
+        const EpochDomain::Guard guard = epochs_.pin();
+        const SubscriberList& list = *list_.load();
+        if (list.log != nullptr) {
+            list.log->append(event);
+        }
+        if (list.lanes.empty()) {
+            for (OrderObserver* observer : list.observers) {
+                observer->onOrderCreated(event);
+            }
+            return;
+        }
+        PooledEvent* pooled = list.slab->acquire(event, nowNs(), static_cast<std::uint32_t>(list.lanes.size()));
+        for (Lane* lane : list.lanes) {
+            enqueue(*lane, pooled);
         }
     }
 
 private:
-    std::vector<std::shared_ptr<OrderObserver>> observers_;
+    struct Lane {
+        Lane(OrderObserver* target, EventSlab* events, std::size_t capacity)
+            : observer(target),
+              slab(events),
+              ring(capacity),
+              enqueue_ns(new std::atomic<std::int64_t>[capacity]),
+              enqueue_ns_mask(capacity - 1) {
+            for (std::size_t i = 0; i < capacity; ++i) {
+                enqueue_ns[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        OrderObserver* observer;
+        EventSlab* slab;
+        MpmcRing<PooledEvent*> ring;
+        std::thread worker;
+        std::atomic<bool> stopping{false};
+        std::vector<OrderCreatedEvent> batch;
+
+        // Once anything spills, producers keep spilling until the worker catches up,
+        // so a later event never overtakes an earlier one through the ring.
+        std::mutex spill_mutex;
+        std::deque<PooledEvent*> spill;
+        std::atomic<bool> spilling{false};
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::atomic<bool> idle{false};
+
+        std::atomic<std::uint64_t> enqueued{0};
+        std::atomic<std::uint64_t> delivered{0};
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::uint64_t> spilled{0};
+        std::atomic<std::int64_t> max_lag_ns{0};
+
+        // Enqueue time by lane sequence, so the oldest undelivered event is enqueue_ns[delivered].
+        // A slot is only overwritten once its event is delivered; while a spill runs deeper than
+        // the ring the head reads an older time, so a backed-up lane over-reports rather than under.
+        std::unique_ptr<std::atomic<std::int64_t>[]> enqueue_ns;
+        std::size_t enqueue_ns_mask;
+    };
+
+    // Immutable once published; only the writer that retires it may free it.
+    struct SubscriberList {
+        std::vector<OrderObserver*> observers;
+        std::vector<Lane*> lanes;  // empty while publishing synchronously
+        EventSlab* slab = nullptr;
+        OrderEventLog* log = nullptr;
+    };
+
+    struct Subscriber {
+        SubscriptionId id = 0;
+        std::shared_ptr<OrderObserver> observer;
+        std::unique_ptr<Lane> lane;
+    };
+
+    struct Retired {
+        const SubscriberList* list;
+        std::uint64_t epoch;
+        Subscriber removed;  // an unsubscribed observer stays alive as long as the list that named it
+    };
+
+    std::uint64_t publishList() { return publishList(Subscriber()); }
+
+    // Swaps in a list built from subscribers_ and returns the epoch its predecessor was retired at.
+    std::uint64_t publishList(Subscriber removed) {
+        auto next = std::make_unique<SubscriberList>();
+        for (const auto& subscriber : subscribers_) {
+            next->observers.push_back(subscriber.observer.get());
+            if (subscriber.lane != nullptr) {
+                next->lanes.push_back(subscriber.lane.get());
+            }
+        }
+        next->slab = slab_.get();
+        next->log = log_;
+        const SubscriberList* old = list_.exchange(next.release());
+        const std::uint64_t retired_at = epochs_.advance();
+        retired_.push_back(Retired{old, retired_at, std::move(removed)});
+        reclaim();
+        return retired_at;
+    }
+
+    void reclaim() {
+        const std::uint64_t oldest = epochs_.oldestActive();
+        auto keep = retired_.begin();
+        for (auto it = retired_.begin(); it != retired_.end(); ++it) {
+            if (it->epoch < oldest) {
+                delete it->list;
+                if (it->removed.lane != nullptr) {
+                    stopLane(*it->removed.lane);
+                }
+            } else {
+                *keep++ = std::move(*it);
+            }
+        }
+        retired_.erase(keep, retired_.end());
+    }
+
+    void waitForReaders(std::uint64_t retired_at) {
+        if (epochs_.pinnedByCurrentThread()) {
+            throw std::logic_error("OrderPublisher: subscriber change from inside an observer would deadlock");
+        }
+        while (epochs_.oldestActive() <= retired_at) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::unique_ptr<Lane> startLane(OrderObserver* observer) {
+        auto lane = std::make_unique<Lane>(observer, slab_.get(), options_.queue_capacity);
+        lane->worker = std::thread([this, target = lane.get()] { drain(*target); });
+        return lane;
+    }
+
+    void stopLane(Lane& lane) {
+        lane.stopping.store(true);
+        {
+            std::lock_guard<std::mutex> lock(lane.wake_mutex);
+            lane.wake.notify_one();
+        }
+        lane.worker.join();
+        addLaneStats(stats_, lane);
+    }
+
+    static void addLaneStats(AsyncPublishStats& stats, const Lane& lane) {
+        stats.enqueued += lane.enqueued.load();
+        stats.dropped += lane.dropped.load();
+        stats.spilled += lane.spilled.load();
+    }
+
+    static std::int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Counted before the push, so the worker can never deliver an event that depth does not include.
+    void enqueue(Lane& lane, PooledEvent* pending) {
+        const std::uint64_t sequence = lane.enqueued.fetch_add(1);
+        if (sequence - lane.delivered.load(std::memory_order_relaxed) <= lane.enqueue_ns_mask) {
+            lane.enqueue_ns[sequence & lane.enqueue_ns_mask].store(pending->enqueued_ns,
+                                                                   std::memory_order_relaxed);
+        }
+        switch (options_.backpressure) {
+        case Backpressure::Block:
+            while (!lane.ring.tryPush(pending)) {
+                std::this_thread::yield();
+            }
+            break;
+        case Backpressure::Drop:
+            if (!lane.ring.tryPush(pending)) {
+                lane.enqueued.fetch_sub(1);
+                lane.dropped.fetch_add(1, std::memory_order_relaxed);
+                lane.slab->release(pending);
+                return;
+            }
+            break;
+        case Backpressure::Spill:
+            if (lane.spilling.load() || !lane.ring.tryPush(pending)) {
+                std::lock_guard<std::mutex> lock(lane.spill_mutex);
+                lane.spill.push_back(pending);
+                lane.spilling.store(true);
+                lane.spilled.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+        if (lane.idle.load()) {
+            std::lock_guard<std::mutex> lock(lane.wake_mutex);
+            lane.wake.notify_one();
+        }
+    }
+
+    // Spilled events taken by the worker come first; the ring only refills after the spill is empty.
+    static bool takeNext(Lane& lane, std::deque<PooledEvent*>& spilled, PooledEvent*& out) {
+        if (spilled.empty()) {
+            if (lane.ring.tryPop(out)) {
+                return true;
+            }
+            if (!lane.spilling.load()) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(lane.spill_mutex);
+            spilled.swap(lane.spill);
+            if (spilled.empty()) {
+                lane.spilling.store(false);
+                return false;
+            }
+        }
+        out = spilled.front();
+        spilled.pop_front();
+        return true;
+    }
+
+    void drain(Lane& lane) {
+        const bool batching = lane.observer->supportsBatch();
+        if (batching) {
+            lane.batch.reserve(options_.max_batch);
+        }
+        PooledEvent* pending = nullptr;
+        std::deque<PooledEvent*> spilled;
+        for (;;) {
+            if (takeNext(lane, spilled, pending)) {
+                if (batching) {
+                    deliverBatch(lane, spilled, pending);
+                } else {
+                    deliver(lane, pending);
+                }
+                continue;
+            }
+            if (lane.stopping.load() && lane.ring.empty() && !lane.spilling.load()) {
+                return;
+            }
+            waitForWork(lane, std::chrono::milliseconds(1));
+        }
+    }
+
+    static void waitForWork(Lane& lane, std::chrono::nanoseconds timeout) {
+        std::unique_lock<std::mutex> lock(lane.wake_mutex);
+        lane.idle.store(true);
+        if (lane.ring.empty() && !lane.spilling.load()) {
+            // The timeout covers a wake-up lost between the empty() check and a producer's idle load.
+            lane.wake.wait_for(lock, timeout);
+        }
+        lane.idle.store(false);
+    }
+
+    static void recordLag(Lane& lane, std::int64_t enqueued_ns) {
+        const std::int64_t lag = nowNs() - enqueued_ns;
+        if (lag > lane.max_lag_ns.load(std::memory_order_relaxed)) {
+            lane.max_lag_ns.store(lag, std::memory_order_relaxed);
+        }
+    }
+
+    void deliver(Lane& lane, PooledEvent* pending) {
+        recordLag(lane, pending->enqueued_ns);
+        lane.observer->onOrderCreated(pending->event);
+        lane.slab->release(pending);
+        lane.delivered.fetch_add(1);
+        lane.batches.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Collects up to max_batch events, waiting at most max_linger after the first for stragglers.
+    // Lag is taken for the oldest event when the batch is handed over, so it includes the linger.
+    void deliverBatch(Lane& lane, std::deque<PooledEvent*>& spilled, PooledEvent* first) {
+        const std::int64_t oldest_ns = first->enqueued_ns;
+        lane.batch.clear();
+        lane.batch.push_back(first->event);
+        lane.slab->release(first);
+
+        const auto deadline = std::chrono::steady_clock::now() + options_.max_linger;
+        PooledEvent* next = nullptr;
+        while (lane.batch.size() < options_.max_batch) {
+            if (takeNext(lane, spilled, next)) {
+                lane.batch.push_back(next->event);
+                lane.slab->release(next);
+                continue;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline || lane.stopping.load()) {
+                break;
+            }
+            waitForWork(lane, deadline - now);
+        }
+        recordLag(lane, oldest_ns);
+        lane.observer->onOrderCreatedBatch(lane.batch.data(), lane.batch.size());
+        lane.delivered.fetch_add(lane.batch.size());
+        lane.batches.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    mutable EpochDomain epochs_;
+    std::atomic<const SubscriberList*> list_;
+    std::vector<Retired> retired_;
+
+    // Writer-side state, guarded by writer_mutex_.
+    mutable std::mutex writer_mutex_;
+    std::vector<Subscriber> subscribers_;
+    SubscriptionId next_id_ = 1;
+    AsyncPublishOptions options_;
+    std::unique_ptr<EventSlab> slab_;
+    OrderEventLog* log_ = nullptr;
+    AsyncPublishStats stats_;
 };
 
 class OrderService {
@@ -70,7 +1465,525 @@ private:
     OrderPublisher& publisher_;
 };
 
-int main() {
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Stands in for an observer that talks to a mail gateway, SMS provider or database.
+class SlowObserver final : public OrderObserver {
+public:
+    explicit SlowObserver(std::chrono::microseconds latency) : latency_(latency) {}
+
+    void onOrderCreated(const OrderCreatedEvent& event) override {
+        delivered_at_.push_back(std::chrono::steady_clock::now());
+        if (latency_.count() > 0) {
+            std::this_thread::sleep_for(latency_);
+        }
+        doNotOptimize(event.amount);
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t delivered() const { return delivered_.load(); }
+
+    // Only read once delivery has stopped.
+    const std::vector<std::chrono::steady_clock::time_point>& deliveredAt() const { return delivered_at_; }
+
+private:
+    std::chrono::microseconds latency_;
+    std::atomic<std::uint64_t> delivered_{0};
+    std::vector<std::chrono::steady_clock::time_point> delivered_at_;
+};
+
+void runAsyncPublishBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kOrders = 2000;
+    constexpr std::size_t kObservers = 4;
+
+    std::cout << "\nplaceOrder publish with " << kObservers << " observers of 100us, " << kOrders
+              << " orders\n";
+    std::cout << std::left << std::setw(16) << "mode" << std::setw(11) << "p50 us" << std::setw(11) << "p99 us"
+              << std::setw(14) << "events/s" << "dropped/spilled\n";
+
+    const auto run = [&](const char* mode, const AsyncPublishOptions* options) {
+        OrderPublisher publisher;
+        std::vector<std::shared_ptr<SlowObserver>> observers;
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            observers.push_back(std::make_shared<SlowObserver>(std::chrono::microseconds(100)));
+            publisher.subscribe(observers.back());
+        }
+        if (options != nullptr) {
+            publisher.startAsync(*options);
+        }
+
+        std::vector<double> latency_us(kOrders);
+        const OrderCreatedEvent event{"ORD-000000001", "U-000000001", 88.0};
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < kOrders; ++i) {
+            const auto begin = clock::now();
+            publisher.publish(event);
+            latency_us[i] = std::chrono::duration<double, std::micro>(clock::now() - begin).count();
+        }
+        const AsyncPublishStats stats = publisher.asyncStats();
+        publisher.stopAsync();
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        std::uint64_t delivered = 0;
+        for (const auto& observer : observers) {
+            delivered += observer->delivered();
+        }
+        std::sort(latency_us.begin(), latency_us.end());
+        std::cout << std::left << std::setw(16) << mode << std::fixed << std::setprecision(1) << std::setw(11)
+                  << latency_us[kOrders / 2] << std::setw(11) << latency_us[kOrders * 99 / 100] << std::setw(14)
+                  << std::setprecision(0) << delivered / kObservers / seconds << stats.dropped << "/"
+                  << stats.spilled << "\n";
+    };
+
+    run("synchronous", nullptr);
+    for (const auto& mode : {std::make_pair("async block", Backpressure::Block),
+                             std::make_pair("async drop", Backpressure::Drop),
+                             std::make_pair("async spill", Backpressure::Spill)}) {
+        const AsyncPublishOptions options{256, mode.second};
+        run(mode.first, &options);
+    }
+}
+
+void runSlowObserverIsolationBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kOrders = 20;
+    const std::vector<std::chrono::microseconds> latencies{
+        std::chrono::microseconds(50'000), std::chrono::microseconds(0), std::chrono::microseconds(0),
+        std::chrono::microseconds(0)};
+    const char* const names[] = {"sms (50ms)", "email", "points", "push"};
+
+    std::cout << "\nDelivery latency with one 50ms observer, " << kOrders << " orders 1ms apart (ms)\n";
+    std::cout << std::left << std::setw(28) << "mode / observer" << std::setw(10) << "p50" << std::setw(10) << "max"
+              << "lane depth/lag at end of publishing\n";
+
+    for (const bool async : {false, true}) {
+        OrderPublisher publisher;
+        std::vector<std::shared_ptr<SlowObserver>> observers;
+        for (const auto latency : latencies) {
+            observers.push_back(std::make_shared<SlowObserver>(latency));
+            publisher.subscribe(observers.back());
+        }
+        if (async) {
+            publisher.startAsync(AsyncPublishOptions{64, Backpressure::Spill});
+        }
+
+        std::vector<clock::time_point> published_at;
+        const OrderCreatedEvent event{"ORD-000000001", "U-000000001", 88.0};
+        for (std::size_t i = 0; i < kOrders; ++i) {
+            published_at.push_back(clock::now());
+            publisher.publish(event);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const std::vector<ObserverQueueStats> lanes = publisher.observerStats();
+        publisher.stopAsync();
+
+        for (std::size_t o = 0; o < observers.size(); ++o) {
+            const auto& delivered_at = observers[o]->deliveredAt();
+            std::vector<double> latency_ms;
+            for (std::size_t i = 0; i < delivered_at.size(); ++i) {
+                latency_ms.push_back(std::chrono::duration<double, std::milli>(delivered_at[i] - published_at[i]).count());
+            }
+            std::sort(latency_ms.begin(), latency_ms.end());
+            std::cout << std::left << std::setw(28) << (std::string(async ? "per-observer / " : "sync / ") + names[o])
+                      << std::fixed << std::setprecision(2) << std::setw(10) << latency_ms[latency_ms.size() / 2]
+                      << std::setw(10) << latency_ms.back();
+            if (async) {
+                std::cout << lanes[o].depth << " / " << lanes[o].current_lag.count() / 1000.0 << "ms";
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
+class CountingObserver final : public OrderObserver {
+public:
+    void onOrderCreated(const OrderCreatedEvent& event) override { total_ += event.amount; }
+    double total() const { return total_; }
+
+private:
+    double total_ = 0;
+};
+
+// The event and publish path as they were before events became flat, kept for comparison.
+struct LegacyOrderCreatedEvent {
+    std::string order_id;
+    std::string user_id;
+    double amount;
+};
+
+class LegacyCountingObserver {
+public:
+    void onOrderCreated(const LegacyOrderCreatedEvent& event) { total_ += event.amount; }
+    double total() const { return total_; }
+
+private:
+    double total_ = 0;
+};
+
+void runFanOutAllocationBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kEvents = 500'000;
+    constexpr std::size_t kObservers = 4;
+    const std::string order_id = "ORD-20261017-00000042";
+    const std::string user_id = "USER-20261017-0000042";
+
+    std::cout << "\nEvent fan-out to " << kObservers << " observers, " << kEvents << " events\n";
+    std::cout << std::left << std::setw(40) << "path" << std::setw(14) << "Mevents/s" << "allocs/event\n";
+    const auto report = [&](const char* path, clock::time_point start, std::uint64_t allocations) {
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        const double allocs = static_cast<double>(g_heap_allocations.load() - allocations) / kEvents;
+        std::cout << std::left << std::setw(40) << path << std::setw(14) << std::fixed << std::setprecision(2)
+                  << kEvents / seconds / 1e6 << allocs << "\n";
+    };
+
+    {
+        std::vector<std::shared_ptr<LegacyCountingObserver>> observers;
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            observers.push_back(std::make_shared<LegacyCountingObserver>());
+        }
+        const std::uint64_t allocations = g_heap_allocations.load();
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < kEvents; ++i) {
+            const LegacyOrderCreatedEvent event{order_id, user_id, 88.0};
+            for (const auto& observer : observers) {
+                observer->onOrderCreated(event);
+            }
+        }
+        report("sync, std::string event", start, allocations);
+        doNotOptimize(observers[0]->total());
+    }
+    {
+        OrderPublisher publisher;
+        auto observer = std::make_shared<CountingObserver>();
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            publisher.subscribe(observer);
+        }
+        const std::uint64_t allocations = g_heap_allocations.load();
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < kEvents; ++i) {
+            publisher.publish(OrderCreatedEvent{order_id, user_id, 88.0});
+        }
+        report("sync, inline event + raw observers", start, allocations);
+        doNotOptimize(observer->total());
+    }
+
+    // Handoff cost of the async path on one thread: publish into every lane's ring, then drain.
+    constexpr std::size_t kBurst = 256;
+    {
+        using EventPtr = std::shared_ptr<const LegacyOrderCreatedEvent>;
+        std::vector<std::unique_ptr<MpmcRing<EventPtr>>> rings;
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            rings.push_back(std::make_unique<MpmcRing<EventPtr>>(kBurst));
+        }
+        LegacyCountingObserver observer;
+        const std::uint64_t allocations = g_heap_allocations.load();
+        const auto start = clock::now();
+        EventPtr popped;
+        for (std::size_t i = 0; i < kEvents; i += kBurst) {
+            for (std::size_t j = 0; j < kBurst; ++j) {
+                const auto shared = std::make_shared<const LegacyOrderCreatedEvent>(
+                    LegacyOrderCreatedEvent{order_id, user_id, 88.0});
+                for (auto& ring : rings) {
+                    EventPtr copy = shared;
+                    ring->tryPush(copy);
+                }
+            }
+            for (auto& ring : rings) {
+                while (ring->tryPop(popped)) {
+                    observer.onOrderCreated(*popped);
+                    popped.reset();
+                }
+            }
+        }
+        report("lane handoff, make_shared event", start, allocations);
+        doNotOptimize(observer.total());
+    }
+    {
+        EventSlab slab(kBurst);
+        std::vector<std::unique_ptr<MpmcRing<PooledEvent*>>> rings;
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            rings.push_back(std::make_unique<MpmcRing<PooledEvent*>>(kBurst));
+        }
+        CountingObserver observer;
+        const std::uint64_t allocations = g_heap_allocations.load();
+        const auto start = clock::now();
+        PooledEvent* popped = nullptr;
+        for (std::size_t i = 0; i < kEvents; i += kBurst) {
+            for (std::size_t j = 0; j < kBurst; ++j) {
+                PooledEvent* pooled = slab.acquire(OrderCreatedEvent{order_id, user_id, 88.0}, 0, kObservers);
+                for (auto& ring : rings) {
+                    ring->tryPush(pooled);
+                }
+            }
+            for (auto& ring : rings) {
+                while (ring->tryPop(popped)) {
+                    observer.onOrderCreated(popped->event);
+                    slab.release(popped);
+                }
+            }
+        }
+        report("lane handoff, slab event", start, allocations);
+        doNotOptimize(observer.total());
+    }
+    {
+        OrderPublisher publisher;
+        for (std::size_t i = 0; i < kObservers; ++i) {
+            publisher.subscribe(std::make_shared<CountingObserver>());
+        }
+        publisher.startAsync(AsyncPublishOptions{1024, Backpressure::Block, 4096});
+        const std::uint64_t allocations = g_heap_allocations.load();
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < kEvents; ++i) {
+            publisher.publish(OrderCreatedEvent{order_id, user_id, 88.0});
+        }
+        const std::uint64_t overflows = publisher.asyncStats().pool_overflows;
+        report("async publisher end to end", start, allocations);
+        publisher.stopAsync();
+        std::cout << "  (slab overflows: " << overflows << ")\n";
+    }
+}
+
+// One database round trip per call, whatever the number of rows.
+class DbWriteObserver final : public OrderObserver {
+public:
+    DbWriteObserver(std::chrono::microseconds write_rtt, bool batch) : write_rtt_(write_rtt), batch_(batch) {}
+
+    void onOrderCreated(const OrderCreatedEvent& event) override { onOrderCreatedBatch(&event, 1); }
+
+    bool supportsBatch() const override { return batch_; }
+
+    void onOrderCreatedBatch(const OrderCreatedEvent* events, std::size_t count) override {
+        std::this_thread::sleep_for(write_rtt_);
+        for (std::size_t i = 0; i < count; ++i) {
+            amount_ += events[i].amount;
+        }
+    }
+
+private:
+    std::chrono::microseconds write_rtt_;
+    bool batch_;
+    double amount_ = 0;
+};
+
+void runBatchLingerBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kTicks = 500;
+    constexpr std::size_t kPerTick = 20;  // 20 orders per 1ms tick = 20k orders/s offered
+
+    std::cout << "\nPoints writes at 20k orders/s offered, 200us per database write\n";
+    std::cout << std::left << std::setw(18) << "delivery" << std::setw(12) << "events/s" << std::setw(10) << "writes"
+              << std::setw(11) << "avg batch" << "max lag ms\n";
+
+    const auto run = [&](const char* mode, bool batch, std::chrono::microseconds linger) {
+        OrderPublisher publisher;
+        publisher.subscribe(std::make_shared<DbWriteObserver>(std::chrono::microseconds(200), batch));
+        AsyncPublishOptions options;
+        options.backpressure = Backpressure::Spill;
+        options.max_batch = 256;
+        options.max_linger = linger;
+        publisher.startAsync(options);
+
+        const OrderCreatedEvent event{"ORD-000000001", "U-000000001", 88.0};
+        const auto start = clock::now();
+        for (std::size_t tick = 0; tick < kTicks; ++tick) {
+            for (std::size_t i = 0; i < kPerTick; ++i) {
+                publisher.publish(event);
+            }
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(tick + 1));
+        }
+        ObserverQueueStats stats = publisher.observerStats()[0];
+        while (stats.delivered < kTicks * kPerTick) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            stats = publisher.observerStats()[0];
+        }
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        publisher.stopAsync();
+        std::cout << std::left << std::setw(18) << mode << std::setw(12) << std::fixed << std::setprecision(0)
+                  << stats.delivered / seconds << std::setw(10) << stats.batches << std::setw(11)
+                  << std::setprecision(1) << static_cast<double>(stats.delivered) / stats.batches
+                  << stats.max_lag.count() / 1000.0 << "\n";
+    };
+
+    run("single", false, std::chrono::microseconds(0));
+    for (const int linger_us : {0, 1000, 5000, 20000}) {
+        const std::string mode = "batch linger " + std::to_string(linger_us / 1000) + "ms";
+        run(mode.c_str(), true, std::chrono::microseconds(linger_us));
+    }
+}
+
+class AtomicCountingObserver final : public OrderObserver {
+public:
+    void onOrderCreated(const OrderCreatedEvent&) override { count_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> count_{0};
+};
+
+class MutexGuardedPublisher {
+public:
+    SubscriptionId subscribe(std::shared_ptr<OrderObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        observers_.emplace_back(next_id_, std::move(observer));
+        return next_id_++;
+    }
+
+    bool unsubscribe(SubscriptionId id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = std::find_if(observers_.begin(), observers_.end(),
+                                     [id](const auto& entry) { return entry.first == id; });
+        if (it == observers_.end()) {
+            return false;
+        }
+        observers_.erase(it);
+        return true;
+    }
+
+    void publish(const OrderCreatedEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : observers_) {
+            entry.second->onOrderCreated(event);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<SubscriptionId, std::shared_ptr<OrderObserver>>> observers_;
+    SubscriptionId next_id_ = 1;
+};
+
+// Publishers run flat out while one thread keeps subscribing and unsubscribing an extra observer.
+template <typename Publisher>
+std::pair<double, double> stressSubscriptionChurn(Publisher& publisher, std::size_t publishers,
+                                                  std::chrono::milliseconds duration) {
+    for (int i = 0; i < 4; ++i) {
+        publisher.subscribe(std::make_shared<AtomicCountingObserver>());
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> published{0};
+    std::uint64_t churned = 0;
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < publishers; ++t) {
+        threads.emplace_back([&] {
+            const OrderCreatedEvent event{"ORD-000000001", "U-000000001", 88.0};
+            std::uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                publisher.publish(event);
+                ++local;
+            }
+            published.fetch_add(local);
+        });
+    }
+    threads.emplace_back([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            const SubscriptionId id = publisher.subscribe(std::make_shared<AtomicCountingObserver>());
+            publisher.unsubscribe(id);
+            ++churned;
+        }
+    });
+
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(duration).count();
+    return {published.load() / seconds, churned / seconds};
+}
+
+void runSubscriptionChurnBenchmark() {
+    constexpr std::size_t kPublishers = 4;
+    const std::chrono::milliseconds duration(500);
+
+    std::cout << "\nPublish under subscribe/unsubscribe churn, " << kPublishers << " publisher threads\n";
+    std::cout << std::left << std::setw(26) << "subscriber list" << std::setw(16) << "Mpublishes/s"
+              << "churn ops/s\n";
+    MutexGuardedPublisher locked;
+    const auto mutex = stressSubscriptionChurn(locked, kPublishers, duration);
+    std::cout << std::left << std::setw(26) << "mutex-guarded vector" << std::setw(16) << std::fixed
+              << std::setprecision(2) << mutex.first / 1e6 << std::setprecision(0) << mutex.second << "\n";
+    OrderPublisher publisher;
+    const auto cow = stressSubscriptionChurn(publisher, kPublishers, duration);
+    std::cout << std::left << std::setw(26) << "copy-on-write + epochs" << std::setw(16) << std::setprecision(2)
+              << cow.first / 1e6 << std::setprecision(0) << cow.second << "\n";
+}
+
+std::string makeTempDirectory(const char* prefix) {
+    std::string pattern = (std::filesystem::temp_directory_path() / (std::string(prefix) + "-XXXXXX")).string();
+    if (::mkdtemp(pattern.data()) == nullptr) {
+        throw std::runtime_error("mkdtemp failed: " + std::string(std::strerror(errno)));
+    }
+    return pattern;
+}
+
+void runDurableLogBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kPublishers = 64;
+    const std::chrono::milliseconds duration(1000);
+
+    std::cout << "\nDurable publish, " << kPublishers << " publisher threads, 1MB segments in "
+              << std::filesystem::temp_directory_path().string() << "\n";
+    std::cout << std::left << std::setw(18) << "group commit" << std::setw(12) << "events/s" << std::setw(11)
+              << "p50 us" << std::setw(11) << "p99 us" << "segments\n";
+
+    for (const int window_us : {0, 1000, 5000}) {
+        const std::string directory = makeTempDirectory("order-log-bench");
+        {
+            EventLogOptions options;
+            options.segment_bytes = std::size_t{1} << 20;
+            options.group_commit_window = std::chrono::microseconds(window_us);
+            OrderEventLog log(directory, options);
+            OrderPublisher publisher;
+            publisher.subscribe(std::make_shared<AtomicCountingObserver>());
+            publisher.attachLog(&log);
+
+            std::atomic<bool> stop{false};
+            std::vector<std::vector<double>> latency_us(kPublishers);
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < kPublishers; ++t) {
+                threads.emplace_back([&, t] {
+                    const OrderCreatedEvent event{"ORD-000000001", "U-000000001", 88.0};
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        const auto begin = clock::now();
+                        publisher.publish(event);
+                        latency_us[t].push_back(std::chrono::duration<double, std::micro>(clock::now() - begin).count());
+                    }
+                });
+            }
+            std::this_thread::sleep_for(duration);
+            stop.store(true);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            std::vector<double> all;
+            for (const auto& samples : latency_us) {
+                all.insert(all.end(), samples.begin(), samples.end());
+            }
+            std::sort(all.begin(), all.end());
+            std::cout << std::left << std::setw(18) << (std::to_string(window_us / 1000) + "ms") << std::setw(12)
+                      << std::fixed << std::setprecision(0) << all.size() / std::chrono::duration<double>(duration).count()
+                      << std::setprecision(1) << std::setw(11) << all[all.size() / 2] << std::setw(11)
+                      << all[all.size() * 99 / 100] << log.segmentCount() << "\n";
+
+            if (window_us == 5000) {
+                AtomicCountingObserver recovering;
+                const auto start = clock::now();
+                const std::uint64_t next = log.replay(1, recovering);
+                const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+                std::cout << "replayed " << next - 1 << " events from sequence 1 at " << std::setprecision(0)
+                          << (next - 1) / seconds << " events/s\n";
+            }
+        }
+        std::filesystem::remove_all(directory);
+    }
+}
+
+int main(int argc, char** argv) {
     OrderPublisher publisher;
     publisher.subscribe(std::make_shared<EmailObserver>());
     publisher.subscribe(std::make_shared<SmsObserver>());
@@ -80,8 +1993,49 @@ int main() {
     std::cout << "Observer implementation\n";
     service.placeOrder("ORD-1001", "U-001", 88.0);
 
-    publisher.subscribe(std::make_shared<PushObserver>());
+    const SubscriptionId push = publisher.subscribe(std::make_shared<PushObserver>());
     std::cout << "Push feature added by new observer; OrderService unchanged\n";
     service.placeOrder("ORD-1002", "U-001", 128.0);
+
+    AsyncPublishOptions async_options;
+    async_options.max_linger = std::chrono::milliseconds(5);
+    publisher.startAsync(async_options);
+    std::cout << "Async publishing: one lane per observer, points written in batches\n";
+    service.placeOrder("ORD-1003", "U-002", 66.0);
+    service.placeOrder("ORD-1004", "U-003", 34.0);
+    publisher.stopAsync();
+
+    publisher.unsubscribe(push);
+    std::cout << "Push observer unsubscribed by handle\n";
+    service.placeOrder("ORD-1005", "U-004", 18.0);
+
+    const std::string log_directory = makeTempDirectory("order-log-demo");
+    {
+        OrderEventLog log(log_directory);
+        publisher.attachLog(&log);
+        std::cout << "Durable mode: events are logged before observers run\n";
+        service.placeOrder("ORD-1006", "U-005", 52.0);
+        std::cout << "Ids past 47 bytes are interned, and logged as text next to the event\n";
+        service.placeOrder("ORD-2026-10-17-00000000000000000000000000000000000000000001", "U-005", 9.0);
+        publisher.attachLog(nullptr);
+    }
+    {
+        OrderEventLog reopened(log_directory);
+        PushObserver recovering;
+        std::cout << "Recovering push observer replays from sequence 1\n";
+        reopened.replay(1, recovering);
+    }
+    std::filesystem::remove_all(log_directory);
+
+    service.placeOrder("ORD-6f1c2a9e-3b7d-4e25-9c1a-0d8e5b4f7a21", "U-006", 9.0);
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        runAsyncPublishBenchmark();
+        runSlowObserverIsolationBenchmark();
+        runFanOutAllocationBenchmark();
+        runBatchLingerBenchmark();
+        runSubscriptionChurnBenchmark();
+        runDurableLogBenchmark();
+    }
     return 0;
 }
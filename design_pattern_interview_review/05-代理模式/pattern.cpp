@@ -1,5 +1,30 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -10,44 +35,1134 @@ struct User {
     std::string name;
 };
 
+// Completion for an async fetch: error is null on success. May run on the caller's thread
+// (cache hit) or on whatever thread finished the remote call, so keep it short.
+using UserCallback = std::function<void(std::exception_ptr error, const User& user)>;
+
 class UserService {
 public:
     virtual ~UserService() = default;
     virtual User fetchUser(int user_id) = 0;
+
+    // The default completes inline through fetchUser, so it still blocks the caller.
+    virtual void fetchUserAsync(int user_id, UserCallback done) {
+        User user;
+        std::exception_ptr error;
+        try {
+            user = fetchUser(user_id);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done(error, user);
+    }
+
+    std::future<User> fetchUserFuture(int user_id) {
+        auto promise = std::make_shared<std::promise<User>>();
+        std::future<User> result = promise->get_future();
+        fetchUserAsync(user_id, [promise](std::exception_ptr error, const User& user) {
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(user);
+            }
+        });
+        return result;
+    }
+
+    // Multi-get in request order; the default costs one fetchUser per id.
+    virtual std::vector<User> fetchUsers(const std::vector<int>& user_ids) {
+        std::vector<User> users;
+        users.reserve(user_ids.size());
+        for (const int user_id : user_ids) {
+            users.push_back(fetchUser(user_id));
+        }
+        return users;
+    }
+};
+
+// One thread firing callbacks at their deadlines; pending timers still fire before shutdown.
+class TimerQueue {
+public:
+    using clock = std::chrono::steady_clock;
+
+    TimerQueue() = default;
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    ~TimerQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void schedule(clock::time_point when, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                throw std::logic_error("TimerQueue is shutting down");
+            }
+            if (!worker_.joinable()) {
+                worker_ = std::thread([this] { run(); });
+            }
+            timers_.push(Timer{when, next_sequence_++, std::move(task)});
+        }
+        changed_.notify_one();
+    }
+
+private:
+    struct Timer {
+        clock::time_point when;
+        std::uint64_t sequence;  // FIFO among equal deadlines
+        std::function<void()> task;
+
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : sequence > other.sequence;
+        }
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            if (timers_.empty()) {
+                if (stopping_) {
+                    return;
+                }
+                changed_.wait(lock);
+                continue;
+            }
+            const clock::time_point when = timers_.top().when;
+            if (clock::now() < when) {
+                changed_.wait_until(lock, when);
+                continue;
+            }
+            std::function<void()> task = std::move(const_cast<Timer&>(timers_.top()).task);
+            timers_.pop();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::uint64_t next_sequence_ = 0;
+    bool stopping_ = false;
+    std::thread worker_;
 };
 
 class RemoteUserService final : public UserService {
 public:
+    explicit RemoteUserService(std::chrono::microseconds latency = std::chrono::milliseconds(20))
+        : latency_(latency) {}
+
     User fetchUser(int user_id) override {
-        ++remote_calls;
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        remote_calls.fetch_add(1, std::memory_order_relaxed);
+        if (latency_.count() > 0) {
+            std::this_thread::sleep_for(latency_);
+        }
+        if (user_id <= 0) {
+            throw std::invalid_argument("Unknown user id: " + std::to_string(user_id));
+        }
         return User{user_id, "user-" + std::to_string(user_id)};
     }
 
-    int remote_calls{0};
+    // One round trip for the whole batch.
+    std::vector<User> fetchUsers(const std::vector<int>& user_ids) override {
+        remote_calls.fetch_add(1, std::memory_order_relaxed);
+        if (latency_.count() > 0) {
+            std::this_thread::sleep_for(latency_);
+        }
+        std::vector<User> users;
+        users.reserve(user_ids.size());
+        for (const int user_id : user_ids) {
+            if (user_id <= 0) {
+                throw std::invalid_argument("Unknown user id: " + std::to_string(user_id));
+            }
+            users.push_back(User{user_id, "user-" + std::to_string(user_id)});
+        }
+        return users;
+    }
+
+    // Same latency, but served by the timer thread: no caller thread sleeps through the round trip.
+    void fetchUserAsync(int user_id, UserCallback done) override {
+        remote_calls.fetch_add(1, std::memory_order_relaxed);
+        auto complete = [user_id, done = std::move(done)] {
+            if (user_id <= 0) {
+                done(std::make_exception_ptr(std::invalid_argument("Unknown user id: " + std::to_string(user_id))),
+                     User{});
+            } else {
+                done(nullptr, User{user_id, "user-" + std::to_string(user_id)});
+            }
+        };
+        if (latency_.count() > 0) {
+            timer_.schedule(TimerQueue::clock::now() + latency_, std::move(complete));
+        } else {
+            complete();
+        }
+    }
+
+    std::atomic<int> remote_calls{0};  // round trips
+
+private:
+    std::chrono::microseconds latency_;
+    TimerQueue timer_;
+};
+
+struct CacheOptions {
+    std::size_t capacity = 10000;
+    std::size_t shards = 16;
+    std::chrono::milliseconds ttl{std::chrono::minutes(5)};  // hard: past this a caller blocks on the remote
+    std::chrono::milliseconds soft_ttl{std::chrono::minutes(1)};  // past this the stale value is served and refreshed
+    std::size_t refresh_threads = 2;
+    double protected_ratio = 0.8;  // share of each shard reserved for entries hit at least twice
+};
+
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t expirations = 0;
+    std::uint64_t stale_hits = 0;
+    std::size_t size = 0;
+
+    double hitRatio() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses); }
+};
+
+// Bounded cache split into independently locked shards, each a segmented LRU: new entries start
+// in probation and only a second hit promotes them to the protected segment, so a scan of
+// one-off ids cannot flush the hot set.
+enum class Lookup { Miss, Hit, HitNeedsRefresh };
+
+class ShardedUserCache {
+public:
+    explicit ShardedUserCache(const CacheOptions& options) : ttl_(options.ttl), soft_ttl_(options.soft_ttl) {
+        if (options.capacity == 0 || options.shards == 0 || options.capacity < options.shards) {
+            throw std::invalid_argument("ShardedUserCache: capacity must be at least one entry per shard");
+        }
+        const std::size_t per_shard = options.capacity / options.shards;
+        for (std::size_t i = 0; i < options.shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(
+                per_shard, std::max<std::size_t>(1, static_cast<std::size_t>(per_shard * options.protected_ratio))));
+        }
+    }
+
+    // A hit past the soft TTL is still a hit; exactly one caller per stale entry is told to refresh it.
+    Lookup get(int user_id, User& out) {
+        Shard& shard = shardFor(user_id);
+        const auto now = clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(user_id);
+        if (it == shard.index.end()) {
+            ++shard.stats.misses;
+            return Lookup::Miss;
+        }
+        Node node = it->second;
+        if (node->expires_at <= now) {
+            erase(shard, it);
+            ++shard.stats.expirations;
+            ++shard.stats.misses;
+            return Lookup::Miss;
+        }
+        if (node->is_protected) {
+            shard.protected_list.splice(shard.protected_list.begin(), shard.protected_list, node);
+        } else {
+            node->is_protected = true;
+            shard.protected_list.splice(shard.protected_list.begin(), shard.probation, node);
+            if (shard.protected_list.size() > shard.protected_capacity) {
+                const Node demoted = std::prev(shard.protected_list.end());
+                demoted->is_protected = false;
+                shard.probation.splice(shard.probation.begin(), shard.protected_list, demoted);
+            }
+        }
+        ++shard.stats.hits;
+        out = node->user;
+        if (node->refresh_at > now) {
+            return Lookup::Hit;
+        }
+        ++shard.stats.stale_hits;
+        if (node->refreshing) {
+            return Lookup::Hit;
+        }
+        node->refreshing = true;
+        return Lookup::HitNeedsRefresh;
+    }
+
+    void put(const User& user) {
+        Shard& shard = shardFor(user.id);
+        const auto now = clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(user.id);
+        if (it != shard.index.end()) {
+            it->second->user = user;
+            it->second->refresh_at = now + soft_ttl_;
+            it->second->expires_at = now + ttl_;
+            it->second->refreshing = false;
+            return;
+        }
+        insert(shard, Entry{user, now + soft_ttl_, now + ttl_, false, false});
+    }
+
+    // Inserts a value that was fetched age ago elsewhere (a snapshot), keeping its original TTLs.
+    // Never overwrites a live entry. Returns true when the caller should refresh it in the background.
+    bool restore(const User& user, std::chrono::milliseconds age) {
+        Shard& shard = shardFor(user.id);
+        const auto now = clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(user.id) != 0) {
+            return false;
+        }
+        const bool stale = age >= soft_ttl_;
+        insert(shard, Entry{user, now + soft_ttl_ - age, now + ttl_ - age, false, stale});
+        return stale;
+    }
+
+    std::chrono::milliseconds ttl() const { return ttl_; }
+
+    // Lets the next stale hit try again after a failed background refresh.
+    void cancelRefresh(int user_id) {
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(user_id);
+        if (it != shard.index.end()) {
+            it->second->refreshing = false;
+        }
+    }
+
+    CacheStats stats() const {
+        CacheStats total;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total.hits += shard->stats.hits;
+            total.misses += shard->stats.misses;
+            total.evictions += shard->stats.evictions;
+            total.expirations += shard->stats.expirations;
+            total.stale_hits += shard->stats.stale_hits;
+            total.size += shard->index.size();
+        }
+        return total;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Entry {
+        User user;
+        clock::time_point refresh_at;
+        clock::time_point expires_at;
+        bool is_protected;
+        bool refreshing;
+    };
+    using Node = std::list<Entry>::iterator;
+
+    struct alignas(64) Shard {
+        Shard(std::size_t total, std::size_t protected_size) : capacity(total), protected_capacity(protected_size) {}
+
+        const std::size_t capacity;
+        const std::size_t protected_capacity;
+        mutable std::mutex mutex;
+        std::unordered_map<int, Node> index;
+        std::list<Entry> probation;
+        std::list<Entry> protected_list;
+        CacheStats stats;
+    };
+
+    Shard& shardFor(int user_id) {
+        // Fibonacci hashing spreads sequential ids; the multiply-shift maps the hash onto the shards.
+        const std::uint64_t hash = static_cast<std::uint32_t>(user_id) * 2654435769u;
+        return *shards_[(hash * shards_.size()) >> 32];
+    }
+
+    static void insert(Shard& shard, Entry entry) {
+        if (shard.index.size() >= shard.capacity) {
+            std::list<Entry>& victims = shard.probation.empty() ? shard.protected_list : shard.probation;
+            erase(shard, shard.index.find(victims.back().user.id));
+            ++shard.stats.evictions;
+        }
+        const int user_id = entry.user.id;
+        shard.probation.push_front(std::move(entry));
+        shard.index.emplace(user_id, shard.probation.begin());
+    }
+
+    static void erase(Shard& shard, std::unordered_map<int, Node>::iterator it) {
+        const Node node = it->second;
+        (node->is_protected ? shard.protected_list : shard.probation).erase(node);
+        shard.index.erase(it);
+    }
+
+    std::chrono::milliseconds ttl_;
+    std::chrono::milliseconds soft_ttl_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+struct SnapshotOptions {
+    std::size_t slots = std::size_t{1} << 16;  // power of two; an existing file keeps its own size
+    std::chrono::milliseconds checkpoint_interval{1000};  // 0: only on checkpoint() and shutdown
+};
+
+struct SnapshotStats {
+    std::uint64_t restored = 0;
+    std::uint64_t rejected = 0;  // torn, expired or clock-skewed slots found on lookup
+    std::uint64_t written = 0;
+    std::uint64_t checkpoints = 0;
+};
+
+// Fixed-layout, memory-mapped image of recently fetched users that survives a restart: a header
+// followed by 64-byte slots, open-addressed by user id within an aligned group of slots. Each
+// group belongs to one of a few lock stripes, so lookups and records for different groups do
+// not contend. Opening only
+// maps the file; each slot is validated (checksum, age) the first time it is looked up. Writes
+// go straight into the mapping and a checkpointer thread msyncs the pages dirtied since the
+// last checkpoint. A slot torn by a crash fails its checksum and reads as a miss.
+class UserSnapshot {
+public:
+    explicit UserSnapshot(const std::string& path, const SnapshotOptions& options = {})
+        : path_(path), options_(options) {
+        if (options_.slots == 0 || (options_.slots & (options_.slots - 1)) != 0) {
+            throw std::invalid_argument("UserSnapshot: slot count must be a power of two");
+        }
+        open();
+        if (options_.checkpoint_interval.count() > 0) {
+            checkpointer_ = std::thread([this] { runCheckpointer(); });
+        }
+    }
+
+    UserSnapshot(const UserSnapshot&) = delete;
+    UserSnapshot& operator=(const UserSnapshot&) = delete;
+
+    ~UserSnapshot() {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    // Stops the checkpointer, syncs the remaining writes and unmaps the file. Throws if that sync,
+    // or an earlier background one, failed. Idempotent; afterwards lookups miss and records drop.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (checkpointer_.joinable()) {
+            checkpointer_.join();
+        }
+        std::exception_ptr error = checkpoint_error_;
+        try {
+            sync();
+        } catch (...) {
+            error = error ? error : std::current_exception();
+        }
+        // Waits out a concurrent checkpoint() and every in-flight lookup or record.
+        std::lock_guard<std::mutex> sync_lock(sync_mutex_);
+        for (Stripe& stripe : stripes_) {
+            stripe.mutex.lock();
+        }
+        ::munmap(base_, size_);
+        ::close(fd_);
+        base_ = nullptr;
+        slots_ = nullptr;
+        fd_ = -1;
+        for (Stripe& stripe : stripes_) {
+            stripe.mutex.unlock();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Finds a valid slot for user_id written less than max_age ago.
+    bool lookup(int user_id, std::chrono::milliseconds max_age, User& out, std::chrono::milliseconds& age) {
+        const std::int64_t now = nowMillis();
+        const std::size_t home = homeSlot(user_id);
+        std::lock_guard<std::mutex> lock(stripeFor(home).mutex);
+        if (slots_ == nullptr) {
+            return false;
+        }
+        for (std::size_t probe = 0; probe < kProbeWindow; ++probe) {
+            const Slot& slot = slots_[probeSlot(home, probe)];
+            if (slot.user_id != user_id) {
+                continue;
+            }
+            age = std::chrono::milliseconds(now - slot.written_ms);
+            if (slot.checksum != checksum(slot) || age.count() < 0 || age >= max_age ||
+                slot.name_length > sizeof(slot.name)) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            out = User{user_id, std::string(slot.name, slot.name_length)};
+            restored_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // Takes the slot already holding the id, else a free one, else the oldest in the window.
+    // Names that do not fit a slot are not persisted.
+    void record(const User& user) {
+        if (user.id == 0 || user.name.size() > sizeof(Slot::name)) {
+            return;
+        }
+        const std::int64_t now = nowMillis();
+        const std::size_t home = homeSlot(user.id);
+        std::lock_guard<std::mutex> lock(stripeFor(home).mutex);
+        if (slots_ == nullptr) {
+            return;
+        }
+        Slot* target = nullptr;
+        for (std::size_t probe = 0; probe < kProbeWindow; ++probe) {
+            Slot& slot = slots_[probeSlot(home, probe)];
+            if (slot.user_id == user.id || slot.user_id == 0) {
+                target = &slot;
+                break;
+            }
+            if (target == nullptr || slot.written_ms < target->written_ms) {
+                target = &slot;
+            }
+        }
+        Slot image{};
+        image.user_id = user.id;
+        image.written_ms = now;
+        image.name_length = static_cast<std::uint8_t>(user.name.size());
+        std::memcpy(image.name, user.name.data(), user.name.size());
+        image.checksum = checksum(image);
+        std::memcpy(target, &image, sizeof(image));
+        written_.fetch_add(1, std::memory_order_relaxed);
+        dirty_.store(true, std::memory_order_release);
+    }
+
+    // A no-op once closed; close() takes the last checkpoint.
+    void checkpoint() { sync(); }
+
+    SnapshotStats stats() const {
+        SnapshotStats stats;
+        stats.restored = restored_.load(std::memory_order_relaxed);
+        stats.rejected = rejected_.load(std::memory_order_relaxed);
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.checkpoints = checkpoints_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t slot_size;
+        std::uint64_t slot_count;
+        char reserved[40];
+    };
+
+    struct Slot {
+        std::int32_t user_id;  // 0: empty
+        std::uint32_t checksum;
+        std::int64_t written_ms;  // system clock, so ages survive a restart
+        std::uint8_t name_length;
+        char name[47];
+    };
+
+    static_assert(sizeof(Header) == 64 && sizeof(Slot) == 64, "snapshot layout is fixed");
+    static constexpr char kMagic[8] = {'U', 'S', 'R', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr std::uint32_t kVersion = 2;  // 2: probes stay within an aligned group
+    static constexpr std::size_t kProbeWindow = 8;
+    static constexpr std::size_t kLockStripes = 16;
+
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+    };
+
+    static std::int64_t nowMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static std::uint32_t checksum(const Slot& slot) {
+        std::uint64_t hash = 14695981039346656037ull;
+        const auto mix = [&hash](const void* data, std::size_t length) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < length; ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        mix(&slot.user_id, sizeof(slot.user_id));
+        mix(&slot.written_ms, sizeof(slot.written_ms));
+        mix(&slot.name_length, sizeof(slot.name_length));
+        mix(slot.name, std::min<std::size_t>(slot.name_length, sizeof(slot.name)));
+        return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+    }
+
+    [[noreturn]] static void fail(const std::string& what) {
+        throw std::runtime_error("UserSnapshot: " + what + ": " + std::strerror(errno));
+    }
+
+    std::size_t homeSlot(int user_id) const {
+        const std::uint64_t hash = static_cast<std::uint32_t>(user_id) * 2654435769u;
+        return hash & (slot_count_ - 1);
+    }
+
+    // Probes wrap inside the home slot's group, so one stripe lock covers the whole window.
+    std::size_t probeSlot(std::size_t home, std::size_t probe) const {
+        return (home & ~group_mask_) | ((home + probe) & group_mask_);
+    }
+
+    Stripe& stripeFor(std::size_t home) { return stripes_[(home >> group_shift_) & (kLockStripes - 1)]; }
+
+    // Maps an existing snapshot as is; a missing or unrecognised file is reset to empty slots.
+    void open() {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            fail("open " + path_);
+        }
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0) {
+            ::close(fd_);
+            fail("fstat " + path_);
+        }
+        Header header{};
+        bool valid = static_cast<std::size_t>(info.st_size) >= sizeof(Header) &&
+                     ::pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                     std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                     header.slot_size == sizeof(Slot) && header.slot_count != 0 &&
+                     (header.slot_count & (header.slot_count - 1)) == 0 &&
+                     static_cast<std::uint64_t>(info.st_size) == sizeof(Header) + header.slot_count * sizeof(Slot);
+        slot_count_ = valid ? header.slot_count : options_.slots;
+        size_ = sizeof(Header) + slot_count_ * sizeof(Slot);
+        group_mask_ = std::min(kProbeWindow, slot_count_) - 1;
+        group_shift_ = 0;
+        while ((std::size_t{1} << group_shift_) <= group_mask_) {
+            ++group_shift_;
+        }
+        // Reserves the blocks up front, so a full disk fails here rather than as SIGBUS on a later
+        // store into the mapping.
+        if (!valid) {
+            const int rc = ::ftruncate(fd_, 0) != 0 ? errno : ::posix_fallocate(fd_, 0, static_cast<off_t>(size_));
+            if (rc != 0) {
+                ::close(fd_);
+                errno = rc;
+                fail("allocate " + path_);
+            }
+        }
+        void* base = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            ::close(fd_);
+            fail("mmap " + path_);
+        }
+        base_ = static_cast<char*>(base);
+        slots_ = reinterpret_cast<Slot*>(base_ + sizeof(Header));
+        if (!valid) {
+            header = Header{};
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kVersion;
+            header.slot_size = sizeof(Slot);
+            header.slot_count = slot_count_;
+            std::memcpy(base_, &header, sizeof(header));
+            dirty_.store(true);
+        }
+    }
+
+    void runCheckpointer() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wake_.wait_for(lock, options_.checkpoint_interval, [this] { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+            lock.unlock();
+            try {
+                sync();
+            } catch (...) {
+                // Surfaced by close(); the mapping stays writable until then.
+                checkpoint_error_ = std::current_exception();
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    // The kernel writes back only the pages dirtied since the last sync. A record that lands
+    // after the flag is cleared sets it again for the next sync.
+    void sync() {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        if (base_ == nullptr || !dirty_.exchange(false)) {
+            return;
+        }
+        if (::msync(base_, size_, MS_SYNC) != 0) {
+            dirty_.store(true);
+            fail("msync " + path_);
+        }
+        checkpoints_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::string path_;
+    const SnapshotOptions options_;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t slot_count_ = 0;
+    Slot* slots_ = nullptr;
+    std::size_t group_mask_ = 0;  // probe group size - 1
+    int group_shift_ = 0;         // log2 of the probe group size
+    Stripe stripes_[kLockStripes];
+    std::mutex sync_mutex_;  // held across msync and the final unmap
+    std::mutex mutex_;       // guards stopping_
+    std::condition_variable wake_;
+    std::atomic<std::uint64_t> restored_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> checkpoints_{0};
+    std::atomic<bool> dirty_{false};
+    bool stopping_ = false;
+    std::exception_ptr checkpoint_error_;  // written by the checkpointer, read after joining it
+    std::thread checkpointer_;
+};
+
+class TaskPool {
+public:
+    explicit TaskPool(std::size_t threads) : threads_(threads) {}
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (workers_.empty()) {
+                for (std::size_t i = 0; i < threads_; ++i) {
+                    workers_.emplace_back([this] { run(); });
+                }
+            }
+            tasks_.push_back(std::move(task));
+        }
+        ready_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    const std::size_t threads_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
+
+enum class MissPolicy { FetchEach, Coalesce };
+
+struct FlightStats {
+    std::uint64_t remote_fetches = 0;
+    std::uint64_t coalesced_waiters = 0;  // misses served by another caller's fetch
+    std::uint64_t failed_fetches = 0;
+    std::uint64_t background_refreshes = 0;
 };
 
 class CachedUserServiceProxy final : public UserService {
 public:
-    explicit CachedUserServiceProxy(RemoteUserService& target) : target_(target) {}
+    explicit CachedUserServiceProxy(RemoteUserService& target, const CacheOptions& options = {},
+                                    MissPolicy misses = MissPolicy::Coalesce)
+        : target_(target), cache_(options), misses_(misses), refresher_(options.refresh_threads) {}
+
+    CachedUserServiceProxy(const CachedUserServiceProxy&) = delete;
+    CachedUserServiceProxy& operator=(const CachedUserServiceProxy&) = delete;
+
+    // Remote async completions call back into the proxy, so it waits for every outstanding one
+    // before the cache and flights they touch go away.
+    ~CachedUserServiceProxy() {
+        std::unique_lock<std::mutex> lock(async_mutex_);
+        async_drained_.wait(lock, [this] { return async_in_flight_ == 0; });
+    }
 
     User fetchUser(int user_id) override {
-        const auto it = cache_.find(user_id);
-        if (it != cache_.end()) {
-            return it->second;
+        User user;
+        const Lookup lookup = cache_.get(user_id, user);
+        if (lookup != Lookup::Miss) {
+            if (lookup == Lookup::HitNeedsRefresh) {
+                scheduleRefresh(user_id);
+            }
+            return user;
         }
+        if (restoreFromSnapshot(user_id, user)) {
+            return user;
+        }
+        if (misses_ == MissPolicy::FetchEach) {
+            return fetchAndFill(user_id);
+        }
+        return fetchCoalesced(user_id);
+    }
 
-        const User user = target_.fetchUser(user_id);
-        cache_[user_id] = user;
-        return user;
+    // Hits complete inline; a miss joins or starts a flight and completes when the remote does.
+    void fetchUserAsync(int user_id, UserCallback done) override {
+        User user;
+        const Lookup lookup = cache_.get(user_id, user);
+        if (lookup != Lookup::Miss) {
+            if (lookup == Lookup::HitNeedsRefresh) {
+                scheduleRefresh(user_id);
+            }
+            done(nullptr, user);
+            return;
+        }
+        if (restoreFromSnapshot(user_id, user)) {
+            done(nullptr, user);
+            return;
+        }
+        if (misses_ == MissPolicy::FetchEach) {
+            remote_fetches_.fetch_add(1, std::memory_order_relaxed);
+            beginAsync();
+            try {
+                target_.fetchUserAsync(user_id, [this, done = std::move(done)](std::exception_ptr error,
+                                                                              const User& fetched) {
+                    const AsyncScope scope{this};
+                    if (error) {
+                        failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        fill(fetched);
+                    }
+                    done(error, fetched);
+                });
+            } catch (...) {
+                endAsync();
+                throw;
+            }
+            return;
+        }
+
+        auto promise = std::make_shared<std::promise<User>>();
+        {
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            const auto it = flights_.find(user_id);
+            if (it != flights_.end()) {
+                coalesced_waiters_.fetch_add(1, std::memory_order_relaxed);
+                it->second.callbacks.push_back(std::move(done));
+                return;
+            }
+            Flight flight{promise->get_future().share(), {}};
+            flight.callbacks.push_back(std::move(done));
+            flights_.emplace(user_id, std::move(flight));
+        }
+        remote_fetches_.fetch_add(1, std::memory_order_relaxed);
+        beginAsync();
+        try {
+            target_.fetchUserAsync(user_id, [this, user_id, promise](std::exception_ptr error, const User& fetched) {
+                const AsyncScope scope{this};
+                if (error) {
+                    failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+                    promise->set_exception(error);
+                } else {
+                    fill(fetched);
+                    promise->set_value(fetched);
+                }
+                finishFlight(user_id, error, fetched);
+            });
+        } catch (...) {
+            // Never issued: fail the flight so the callers that joined it are not left waiting.
+            endAsync();
+            failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+            promise->set_exception(std::current_exception());
+            finishFlight(user_id, std::current_exception(), User{});
+        }
+    }
+
+    // Hits come from the cache; the distinct misses go to the remote as one batch, joining any
+    // fetch already in flight for an id instead of fetching it again. Results are matched to the
+    // request by user id, so the remote may answer in any order; an id it leaves out fails.
+    std::vector<User> fetchUsers(const std::vector<int>& user_ids) override {
+        std::unordered_map<int, std::vector<std::size_t>> positions;  // id -> positions in the request
+        std::vector<int> distinct;
+        for (std::size_t i = 0; i < user_ids.size(); ++i) {
+            std::vector<std::size_t>& slots = positions[user_ids[i]];
+            if (slots.empty()) {
+                distinct.push_back(user_ids[i]);
+            }
+            slots.push_back(i);
+        }
+        std::vector<User> users(user_ids.size());
+        const auto place = [&](const User& user) {
+            for (const std::size_t position : positions.at(user.id)) {
+                users[position] = user;
+            }
+        };
+
+        std::vector<int> missing;
+        for (const int user_id : distinct) {
+            User user;
+            const Lookup lookup = cache_.get(user_id, user);
+            if (lookup == Lookup::Miss && !restoreFromSnapshot(user_id, user)) {
+                missing.push_back(user_id);
+                continue;
+            }
+            if (lookup == Lookup::HitNeedsRefresh) {
+                scheduleRefresh(user_id);
+            }
+            place(user);
+        }
+        if (missing.empty()) {
+            return users;
+        }
+
+        std::vector<int> lead;
+        std::vector<std::promise<User>> promises;  // parallel to lead when coalescing
+        std::vector<std::shared_future<User>> joined;
+        if (misses_ == MissPolicy::Coalesce) {
+            promises.reserve(missing.size());
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            for (const int user_id : missing) {
+                const auto it = flights_.find(user_id);
+                if (it != flights_.end()) {
+                    joined.push_back(it->second.result);
+                } else {
+                    promises.emplace_back();
+                    flights_.emplace(user_id, Flight{promises.back().get_future().share(), {}});
+                    lead.push_back(user_id);
+                }
+            }
+        } else {
+            lead = missing;
+        }
+
+        if (!lead.empty()) {
+            const auto fail = [&](std::size_t index, std::exception_ptr error) {
+                if (!promises.empty()) {
+                    promises[index].set_exception(error);
+                    finishFlight(lead[index], error, User{});
+                }
+            };
+            remote_fetches_.fetch_add(1, std::memory_order_relaxed);
+            std::vector<User> fetched;
+            try {
+                fetched = target_.fetchUsers(lead);
+            } catch (...) {
+                failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+                for (std::size_t i = 0; i < lead.size(); ++i) {
+                    fail(i, std::current_exception());
+                }
+                throw;
+            }
+
+            std::unordered_map<int, std::size_t> pending;  // lead id -> index, until answered
+            for (std::size_t i = 0; i < lead.size(); ++i) {
+                pending.emplace(lead[i], i);
+            }
+            for (const User& user : fetched) {
+                const auto it = pending.find(user.id);
+                if (it == pending.end()) {
+                    continue;  // not asked for, or already answered
+                }
+                fill(user);
+                place(user);
+                if (!promises.empty()) {
+                    promises[it->second].set_value(user);
+                    finishFlight(user.id, nullptr, user);
+                }
+                pending.erase(it);
+            }
+            if (!pending.empty()) {
+                failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+                std::exception_ptr first;
+                for (const auto& entry : pending) {
+                    const std::exception_ptr error = std::make_exception_ptr(
+                        std::runtime_error("Batch response missing user id: " + std::to_string(entry.first)));
+                    fail(entry.second, error);
+                    if (!first) {
+                        first = error;
+                    }
+                }
+                std::rethrow_exception(first);
+            }
+        }
+        for (const auto& flight : joined) {
+            coalesced_waiters_.fetch_add(1, std::memory_order_relaxed);
+            place(flight.get());
+        }
+        return users;
+    }
+
+    // Misses consult the snapshot before the remote, and every fetched user is written to it.
+    // The snapshot must outlive the proxy; attach it before serving traffic.
+    void attachSnapshot(UserSnapshot* snapshot) { snapshot_.store(snapshot); }
+
+    CacheStats cacheStats() const { return cache_.stats(); }
+
+    FlightStats flightStats() const {
+        return FlightStats{remote_fetches_.load(), coalesced_waiters_.load(), failed_fetches_.load(),
+                           background_refreshes_.load()};
     }
 
 private:
+    // A refresh is a flight like any miss: a foreground miss for the same id joins it, and a
+    // refresh that finds a flight already open rides on that one instead of fetching again.
+    void scheduleRefresh(int user_id) {
+        refresher_.submit([this, user_id] {
+            background_refreshes_.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(flights_mutex_);
+                const auto it = flights_.find(user_id);
+                if (it != flights_.end()) {
+                    coalesced_waiters_.fetch_add(1, std::memory_order_relaxed);
+                    it->second.callbacks.push_back([this, user_id](std::exception_ptr error, const User&) {
+                        if (error) {
+                            cache_.cancelRefresh(user_id);
+                        }
+                    });
+                    return;
+                }
+            }
+            try {
+                fetchCoalesced(user_id);
+            } catch (...) {
+                cache_.cancelRefresh(user_id);
+            }
+        });
+    }
+
+    bool restoreFromSnapshot(int user_id, User& out) {
+        UserSnapshot* const snapshot = snapshot_.load(std::memory_order_acquire);
+        std::chrono::milliseconds age{0};
+        if (snapshot == nullptr || !snapshot->lookup(user_id, cache_.ttl(), out, age)) {
+            return false;
+        }
+        if (cache_.restore(out, age)) {
+            scheduleRefresh(user_id);
+        }
+        return true;
+    }
+
+    void fill(const User& user) {
+        cache_.put(user);
+        if (UserSnapshot* const snapshot = snapshot_.load(std::memory_order_acquire)) {
+            snapshot->record(user);
+        }
+    }
+
+    User fetchAndFill(int user_id) {
+        remote_fetches_.fetch_add(1, std::memory_order_relaxed);
+        User user = target_.fetchUser(user_id);
+        fill(user);
+        return user;
+    }
+
+    // Single flight: the first miss for an id fetches it, concurrent misses wait on the same
+    // shared_future and get its value or its exception. Failures are not cached.
+    User fetchCoalesced(int user_id) {
+        std::promise<User> promise;
+        std::shared_future<User> flight;
+        {
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            const auto it = flights_.find(user_id);
+            if (it != flights_.end()) {
+                flight = it->second.result;
+            } else {
+                flights_.emplace(user_id, Flight{promise.get_future().share(), {}});
+            }
+        }
+        if (flight.valid()) {
+            coalesced_waiters_.fetch_add(1, std::memory_order_relaxed);
+            return flight.get();
+        }
+
+        try {
+            const User user = fetchAndFill(user_id);
+            promise.set_value(user);
+            finishFlight(user_id, nullptr, user);
+            return user;
+        } catch (...) {
+            failed_fetches_.fetch_add(1, std::memory_order_relaxed);
+            promise.set_exception(std::current_exception());
+            finishFlight(user_id, std::current_exception(), User{});
+            throw;
+        }
+    }
+
+    // Marks a remote async completion still to run; it ends when the completion returns or throws.
+    struct AsyncScope {
+        CachedUserServiceProxy* proxy;
+        ~AsyncScope() { proxy->endAsync(); }
+    };
+
+    void beginAsync() {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        ++async_in_flight_;
+    }
+
+    // Notifies under the lock: once the destructor sees zero, nothing here touches the proxy.
+    void endAsync() {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        if (--async_in_flight_ == 0) {
+            async_drained_.notify_all();
+        }
+    }
+
+    // Retires the flight, then completes the async callers that joined it, outside the lock.
+    void finishFlight(int user_id, std::exception_ptr error, const User& user) {
+        std::vector<UserCallback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            const auto it = flights_.find(user_id);
+            callbacks = std::move(it->second.callbacks);
+            flights_.erase(it);
+        }
+        for (const auto& done : callbacks) {
+            done(error, user);
+        }
+    }
+
+    // Blocking callers wait on result; async callers queue a callback.
+    struct Flight {
+        std::shared_future<User> result;
+        std::vector<UserCallback> callbacks;
+    };
+
     RemoteUserService& target_;
-    std::unordered_map<int, User> cache_;
+    ShardedUserCache cache_;
+    const MissPolicy misses_;
+    std::atomic<UserSnapshot*> snapshot_{nullptr};
+    std::mutex flights_mutex_;
+    std::unordered_map<int, Flight> flights_;
+    std::atomic<std::uint64_t> remote_fetches_{0};
+    std::atomic<std::uint64_t> coalesced_waiters_{0};
+    std::atomic<std::uint64_t> failed_fetches_{0};
+    std::atomic<std::uint64_t> background_refreshes_{0};
+    std::mutex async_mutex_;
+    std::condition_variable async_drained_;
+    std::size_t async_in_flight_ = 0;
+    TaskPool refresher_;  // last member: joined before the cache it fills goes away
 };
 
-std::vector<User> buildDashboard(UserService& service, const std::vector<int>& user_ids) {
+std::vector<User> buildDashboardPerId(UserService& service, const std::vector<int>& user_ids) {
     std::vector<User> users;
     users.reserve(user_ids.size());
     for (const int user_id : user_ids) {
@@ -56,14 +1171,457 @@ std::vector<User> buildDashboard(UserService& service, const std::vector<int>& u
     return users;
 }
 
-int main() {
+std::vector<User> buildDashboard(UserService& service, const std::vector<int>& user_ids) {
+    return service.fetchUsers(user_ids);
+}
+
+// Per-id async fan-out: up to max_in_flight fetches outstanding at once, each completion starting
+// the next. Blocks until every id has completed; rethrows the first failure.
+std::vector<User> buildDashboardAsync(UserService& service, const std::vector<int>& user_ids,
+                                      std::size_t max_in_flight = 64) {
+    if (max_in_flight == 0) {
+        throw std::invalid_argument("max_in_flight must be positive");
+    }
+    struct FanOut {
+        UserService* service;
+        const std::vector<int>* user_ids;
+        std::size_t max_in_flight;
+        std::mutex mutex;
+        std::condition_variable finished_all;
+        std::vector<User> users;
+        std::exception_ptr error;
+        std::size_t next = 0;
+        std::size_t in_flight = 0;
+        std::size_t finished = 0;
+        bool pumping = false;  // one thread issues at a time; inline completions just return
+
+        static void pump(const std::shared_ptr<FanOut>& self) {
+            std::unique_lock<std::mutex> lock(self->mutex);
+            if (self->pumping) {
+                return;
+            }
+            self->pumping = true;
+            while (self->in_flight < self->max_in_flight && self->next < self->user_ids->size()) {
+                const std::size_t position = self->next++;
+                ++self->in_flight;
+                lock.unlock();
+                self->service->fetchUserAsync((*self->user_ids)[position],
+                                              [self, position](std::exception_ptr error, const User& user) {
+                                                  complete(self, position, error, user);
+                                              });
+                lock.lock();
+            }
+            self->pumping = false;
+        }
+
+        static void complete(const std::shared_ptr<FanOut>& self, std::size_t position, std::exception_ptr error,
+                             const User& user) {
+            {
+                std::lock_guard<std::mutex> lock(self->mutex);
+                if (error) {
+                    if (!self->error) {
+                        self->error = error;
+                    }
+                } else {
+                    self->users[position] = user;
+                }
+                --self->in_flight;
+            }
+            pump(self);
+            std::lock_guard<std::mutex> lock(self->mutex);
+            if (++self->finished == self->user_ids->size()) {
+                self->finished_all.notify_all();
+            }
+        }
+    };
+
+    auto fan_out = std::make_shared<FanOut>();
+    fan_out->service = &service;
+    fan_out->user_ids = &user_ids;
+    fan_out->max_in_flight = max_in_flight;
+    fan_out->users.resize(user_ids.size());
+    FanOut::pump(fan_out);
+    std::unique_lock<std::mutex> lock(fan_out->mutex);
+    fan_out->finished_all.wait(lock, [&] { return fan_out->finished == user_ids.size(); });
+    if (fan_out->error) {
+        std::rethrow_exception(fan_out->error);
+    }
+    return std::move(fan_out->users);
+}
+
+// The proxy as it was (an unbounded map), made shareable with one mutex for comparison.
+class MutexGuardedMapProxy final : public UserService {
+public:
+    explicit MutexGuardedMapProxy(RemoteUserService& target) : target_(target) {}
+
+    User fetchUser(int user_id) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = cache_.find(user_id);
+            if (it != cache_.end()) {
+                ++hits_;
+                return it->second;
+            }
+            ++misses_;
+        }
+        const User user = target_.fetchUser(user_id);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache_[user_id] = user;
+        return user;
+    }
+
+    CacheStats cacheStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CacheStats stats;
+        stats.hits = hits_;
+        stats.misses = misses_;
+        stats.size = cache_.size();
+        return stats;
+    }
+
+private:
+    RemoteUserService& target_;
+    mutable std::mutex mutex_;
+    std::unordered_map<int, User> cache_;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+// Zipf(s) over [1, n] by inverse CDF; one table shared read-only by all threads.
+class ZipfTable {
+public:
+    ZipfTable(std::size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf_[i] = sum;
+        }
+        for (double& value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    int sample(std::mt19937_64& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return static_cast<int>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin()) + 1;
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+template <typename Proxy>
+double runZipfLoad(Proxy& proxy, const ZipfTable& zipf, std::size_t threads, std::size_t total_ops) {
+    using clock = std::chrono::steady_clock;
+    std::vector<std::thread> workers;
+    const auto start = clock::now();
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(42 + t);
+            for (std::size_t i = 0; i < total_ops / threads; ++i) {
+                proxy.fetchUser(zipf.sample(rng));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return total_ops / std::chrono::duration<double>(clock::now() - start).count();
+}
+
+void runCacheBenchmark() {
+    constexpr std::size_t kUsers = 200'000;
+    constexpr std::size_t kOps = 2'000'000;
+    const ZipfTable zipf(kUsers, 0.99);
+    CacheOptions options;
+    options.capacity = 10'000;
+
+    std::cout << "\nZipf(0.99) over " << kUsers << " ids, " << kOps << " lookups, instant remote\n";
+    std::cout << std::left << std::setw(9) << "threads" << std::setw(34) << "unbounded map + mutex (Mops/s)"
+              << std::setw(10) << "hit" << std::setw(38) << "sharded SLRU, 10k entries (Mops/s)" << "hit\n";
+    for (const std::size_t threads : {1, 4, 16, 64}) {
+        RemoteUserService map_remote(std::chrono::microseconds(0));
+        MutexGuardedMapProxy map(map_remote);
+        const double map_ops = runZipfLoad(map, zipf, threads, kOps);
+        const CacheStats map_stats = map.cacheStats();
+
+        RemoteUserService slru_remote(std::chrono::microseconds(0));
+        CachedUserServiceProxy slru(slru_remote, options);
+        const double slru_ops = runZipfLoad(slru, zipf, threads, kOps);
+        const CacheStats slru_stats = slru.cacheStats();
+
+        std::cout << std::left << std::setw(9) << threads << std::setw(34) << std::fixed << std::setprecision(2)
+                  << map_ops / 1e6 << std::setw(10) << std::setprecision(3) << map_stats.hitRatio() << std::setw(38)
+                  << std::setprecision(2) << slru_ops / 1e6 << std::setprecision(3) << slru_stats.hitRatio() << "\n";
+        if (threads == 64) {
+            std::cout << "entries held: map " << map_stats.size << ", SLRU " << slru_stats.size << " ("
+                      << slru_stats.evictions << " evictions)\n";
+        }
+    }
+}
+
+void runColdKeyBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kThreads = 64;
+    constexpr int kColdKeys = 32;
+
+    std::cout << "\n" << kThreads << " threads over " << kColdKeys << " cold ids, 20ms remote\n";
+    std::cout << std::left << std::setw(14) << "misses" << std::setw(14) << "remote calls" << std::setw(11)
+              << "coalesced" << std::setw(10) << "p50 ms" << "p99 ms\n";
+    for (const MissPolicy policy : {MissPolicy::FetchEach, MissPolicy::Coalesce}) {
+        RemoteUserService remote;
+        CachedUserServiceProxy proxy(remote, CacheOptions{}, policy);
+        std::vector<std::vector<double>> latency_ms(kThreads);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<int> ids;
+                for (int id = 1; id <= kColdKeys; ++id) {
+                    ids.push_back(id);
+                }
+                std::mt19937 rng(static_cast<unsigned>(t));
+                std::shuffle(ids.begin(), ids.end(), rng);
+                for (const int id : ids) {
+                    const auto start = clock::now();
+                    proxy.fetchUser(id);
+                    latency_ms[t].push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::vector<double> all;
+        for (const auto& samples : latency_ms) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::cout << std::left << std::setw(14) << (policy == MissPolicy::Coalesce ? "single-flight" : "fetch each")
+                  << std::setw(14) << remote.remote_calls.load() << std::setw(11)
+                  << proxy.flightStats().coalesced_waiters << std::fixed << std::setprecision(1) << std::setw(10)
+                  << all[all.size() / 2] << all[all.size() * 99 / 100] << "\n";
+    }
+}
+
+void runDashboardBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr int kIds = 50;
+
+    std::cout << "\nDashboard of " << kIds << " ids, 20ms remote (ms)\n";
+    std::cout << std::left << std::setw(12) << "hit ratio" << std::setw(14) << "per-id loop" << "multi-get\n";
+    for (const int cached : {0, 25, 45, 50}) {
+        double elapsed[2] = {};
+        for (int variant = 0; variant < 2; ++variant) {
+            RemoteUserService remote;
+            CachedUserServiceProxy proxy(remote);
+            std::vector<int> ids;
+            std::vector<int> warm;
+            for (int id = 1; id <= kIds; ++id) {
+                ids.push_back(id);
+                if (id <= cached) {
+                    warm.push_back(id);
+                }
+            }
+            if (!warm.empty()) {
+                proxy.fetchUsers(warm);
+            }
+            const auto start = clock::now();
+            const auto users = variant == 0 ? buildDashboardPerId(proxy, ids) : buildDashboard(proxy, ids);
+            elapsed[variant] = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            if (users.size() != ids.size() || users.back().id != kIds) {
+                throw std::logic_error("dashboard returned the wrong users");
+            }
+        }
+        std::cout << std::left << std::setw(12) << (std::to_string(cached * 100 / kIds) + "%") << std::setw(14)
+                  << std::fixed << std::setprecision(1) << elapsed[0] << elapsed[1] << "\n";
+    }
+}
+
+void runRevalidateBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr int kIds = 1000;
+    constexpr std::size_t kThreads = 8;
+    const std::chrono::milliseconds duration(2000);
+
+    std::cout << "\nSteady churn: " << kIds << " warm ids, 100ms TTL, " << kThreads << " threads, 20ms remote (us)\n";
+    std::cout << std::left << std::setw(26) << "expiry" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(14) << "remote calls" << "stale hits\n";
+    for (const bool revalidate : {false, true}) {
+        RemoteUserService remote;
+        CacheOptions options;
+        options.soft_ttl = std::chrono::milliseconds(100);
+        options.ttl = revalidate ? std::chrono::milliseconds(10'000) : std::chrono::milliseconds(100);
+        CachedUserServiceProxy proxy(remote, options);
+        std::vector<int> ids;
+        for (int id = 1; id <= kIds; ++id) {
+            ids.push_back(id);
+        }
+        proxy.fetchUsers(ids);
+        const int warmup_calls = remote.remote_calls.load();
+
+        std::atomic<bool> stop{false};
+        std::vector<std::vector<double>> latency_us(kThreads);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(static_cast<unsigned>(t));
+                std::uniform_int_distribution<int> pick(1, kIds);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const auto start = clock::now();
+                    proxy.fetchUser(pick(rng));
+                    latency_us[t].push_back(std::chrono::duration<double, std::micro>(clock::now() - start).count());
+                }
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop.store(true);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::vector<double> all;
+        for (const auto& samples : latency_us) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::cout << std::left << std::setw(26) << (revalidate ? "soft 100ms + hard 10s" : "hard 100ms only")
+                  << std::fixed << std::setprecision(1) << std::setw(10) << all[all.size() / 2] << std::setw(10)
+                  << all[all.size() * 99 / 100] << std::setw(10) << all[all.size() * 999 / 1000] << std::setw(14)
+                  << remote.remote_calls.load() - warmup_calls << proxy.cacheStats().stale_hits << "\n";
+    }
+}
+
+void runAsyncDashboardBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr int kSequentialLimit = 50;  // 500 sequential misses would take ~10s
+
+    std::cout << "\nCold dashboard, 20ms remote: sequential per-id vs async fan-out (ms)\n";
+    std::cout << std::left << std::setw(8) << "ids" << std::setw(14) << "sequential" << std::setw(14)
+              << "async max 16" << std::setw(14) << "async max 64" << "remote calls (async 64)\n";
+    for (const int count : {5, 50, 500}) {
+        std::vector<int> ids;
+        for (int id = 1; id <= count; ++id) {
+            ids.push_back(id);
+        }
+        std::cout << std::left << std::setw(8) << count << std::fixed << std::setprecision(1);
+        if (count <= kSequentialLimit) {
+            RemoteUserService remote;
+            CachedUserServiceProxy proxy(remote);
+            const auto start = clock::now();
+            buildDashboardPerId(proxy, ids);
+            std::cout << std::setw(14) << std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        } else {
+            std::cout << std::setw(14) << "skipped";
+        }
+        int remote_calls = 0;
+        for (const std::size_t limit : {std::size_t{16}, std::size_t{64}}) {
+            RemoteUserService remote;
+            CachedUserServiceProxy proxy(remote);
+            const auto start = clock::now();
+            const auto users = buildDashboardAsync(proxy, ids, limit);
+            std::cout << std::setw(14) << std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            if (users.size() != ids.size() || users.back().id != count) {
+                throw std::logic_error("async dashboard returned the wrong users");
+            }
+            remote_calls = remote.remote_calls.load();
+        }
+        std::cout << remote_calls << "\n";
+    }
+}
+
+std::string makeTempDirectory(const char* prefix) {
+    std::string pattern = (std::filesystem::temp_directory_path() / (std::string(prefix) + "-XXXXXX")).string();
+    if (::mkdtemp(pattern.data()) == nullptr) {
+        throw std::runtime_error("mkdtemp failed: " + std::string(std::strerror(errno)));
+    }
+    return pattern;
+}
+
+void runWarmRestartBenchmark() {
+    using clock = std::chrono::steady_clock;
+    constexpr std::size_t kUsers = 20'000;
+    constexpr std::size_t kRequests = 10'000;
+    constexpr std::size_t kThreads = 32;
+    constexpr std::size_t kWindow = 1'000;
+    constexpr double kWarmRatio = 0.9;
+    const ZipfTable zipf(kUsers, 0.99);
+    const std::string directory = makeTempDirectory("user-snapshot-bench");
+    const std::string path = (std::filesystem::path(directory) / "users.snap").string();
+
+    // The previous process: warmed by real traffic, checkpointed on shutdown.
+    {
+        RemoteUserService remote(std::chrono::microseconds(0));
+        UserSnapshot snapshot(path);
+        CachedUserServiceProxy proxy(remote);
+        proxy.attachSnapshot(&snapshot);
+        runZipfLoad(proxy, zipf, 4, 200'000);
+    }
+
+    std::cout << "\nRestart: first " << kRequests << " Zipf requests over " << kUsers << " users, " << kThreads
+              << " threads, 20ms remote\n";
+    std::cout << std::left << std::setw(16) << "start" << std::setw(12) << "open (ms)" << std::setw(14)
+              << "local ratio" << std::setw(14) << "10k done (ms)" << std::setw(16) << "warm at (ms)"
+              << "remote calls\n";
+    for (const bool warm : {false, true}) {
+        const auto start = clock::now();
+        RemoteUserService remote;
+        std::unique_ptr<UserSnapshot> snapshot;
+        if (warm) {
+            snapshot = std::make_unique<UserSnapshot>(path);
+        }
+        CachedUserServiceProxy proxy(remote);
+        proxy.attachSnapshot(snapshot.get());
+        const double open_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        // Served locally: under 1ms, i.e. no remote round trip on the request's path.
+        std::vector<char> local(kRequests);
+        std::vector<double> done_ms(kRequests);
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937_64 rng(7 + t);
+                for (std::size_t i = next.fetch_add(1); i < kRequests; i = next.fetch_add(1)) {
+                    const auto issued = clock::now();
+                    proxy.fetchUser(zipf.sample(rng));
+                    const auto finished = clock::now();
+                    local[i] = finished - issued < std::chrono::milliseconds(1);
+                    done_ms[i] = std::chrono::duration<double, std::milli>(finished - start).count();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::size_t served_locally = 0;
+        double warm_at = -1;
+        for (std::size_t i = 0; i < kRequests; ++i) {
+            served_locally += local[i];
+            if (warm_at < 0 && i + 1 >= kWindow) {
+                const auto first = local.begin() + static_cast<std::ptrdiff_t>(i + 1 - kWindow);
+                if (std::count(first, first + kWindow, 1) >= kWarmRatio * kWindow) {
+                    warm_at = *std::max_element(done_ms.begin() + (first - local.begin()), done_ms.begin() + i + 1);
+                }
+            }
+        }
+        std::cout << std::left << std::setw(16) << (warm ? "snapshot" : "cold") << std::fixed << std::setprecision(2)
+                  << std::setw(12) << open_ms << std::setw(14) << static_cast<double>(served_locally) / kRequests
+                  << std::setprecision(0) << std::setw(14) << *std::max_element(done_ms.begin(), done_ms.end())
+                  << std::setw(16) << (warm_at < 0 ? std::string("not reached") : std::to_string(std::lround(warm_at)))
+                  << remote.remote_calls.load() << "\n";
+    }
+    std::cout << "warm = first " << kWindow << "-request window with >= " << kWarmRatio * 100 << "% served locally\n";
+    std::filesystem::remove_all(directory);
+}
+
+int main(int argc, char** argv) {
     using clock = std::chrono::steady_clock;
     RemoteUserService remote;
     CachedUserServiceProxy proxy(remote);
     const std::vector<int> user_ids{1, 2, 1, 2, 1};
 
     const auto start = clock::now();
-    const auto users = buildDashboard(proxy, user_ids);
+    const auto users = buildDashboardPerId(proxy, user_ids);
     const auto elapsed_ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
 
@@ -71,5 +1629,71 @@ int main() {
     std::cout << "Users loaded: " << users.size() << "\n";
     std::cout << "Remote calls: " << remote.remote_calls << "\n";
     std::cout << "Elapsed: " << elapsed_ms << "ms\n";
+
+    const CacheStats stats = proxy.cacheStats();
+    std::cout << "Cache hits/misses: " << stats.hits << "/" << stats.misses << ", entries: " << stats.size << "\n";
+
+    {
+        RemoteUserService batch_remote;
+        CachedUserServiceProxy batch_proxy(batch_remote);
+        const auto batch_start = clock::now();
+        const auto batch_users = buildDashboard(batch_proxy, user_ids);
+        std::cout << "Same ids via fetchUsers: " << batch_users.size() << " users, "
+                  << batch_remote.remote_calls.load() << " remote call(s) in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - batch_start).count()
+                  << "ms\n";
+    }
+
+    std::vector<std::thread> herd;
+    std::atomic<int> failures{0};
+    for (int i = 0; i < 8; ++i) {
+        herd.emplace_back([&] {
+            try {
+                proxy.fetchUser(-7);
+            } catch (const std::invalid_argument&) {
+                failures.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : herd) {
+        thread.join();
+    }
+    const FlightStats flights = proxy.flightStats();
+    std::cout << "8 concurrent misses on a bad id: " << failures << " errors from " << flights.failed_fetches
+              << " failed remote fetch(es), " << flights.coalesced_waiters << " coalesced\n";
+
+    const auto async_start = clock::now();
+    const auto async_users = buildDashboardAsync(proxy, {3, 4, 5, 6, 1});
+    std::cout << "Async dashboard: " << async_users.size() << " users in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - async_start).count()
+              << "ms, user 4 via future: " << proxy.fetchUserFuture(4).get().name << "\n";
+
+    const std::string snapshot_directory = makeTempDirectory("user-snapshot-demo");
+    const std::string snapshot_path = (std::filesystem::path(snapshot_directory) / "users.snap").string();
+    {
+        UserSnapshot snapshot(snapshot_path);
+        CachedUserServiceProxy before(remote);
+        before.attachSnapshot(&snapshot);
+        buildDashboard(before, {7, 8, 9});
+    }
+    {
+        UserSnapshot snapshot(snapshot_path);
+        CachedUserServiceProxy after(remote);
+        after.attachSnapshot(&snapshot);
+        const int calls_before = remote.remote_calls.load();
+        const auto restored = buildDashboard(after, {7, 8, 9});
+        std::cout << "After restart: " << restored.size() << " users from the snapshot, "
+                  << remote.remote_calls.load() - calls_before << " remote calls\n";
+    }
+    std::filesystem::remove_all(snapshot_directory);
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        runCacheBenchmark();
+        runColdKeyBenchmark();
+        runDashboardBenchmark();
+        runRevalidateBenchmark();
+        runAsyncDashboardBenchmark();
+        runWarmRestartBenchmark();
+    }
     return 0;
 }